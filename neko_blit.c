@@ -0,0 +1,465 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <core/gp_core.h>
+#include <gfx/gp_gfx.h>
+
+#include "neko_blit.h"
+
+typedef void (*blit_kernel)(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                            gp_pixmap *dst, gp_coord dx, gp_coord dy);
+
+static gp_pixel_type blit_pixel_type;
+static blit_kernel blit;
+
+/* Tile size in pixels for the rotated blit */
+#define TILE 32
+
+static void copy_bytes(const uint8_t *s, uint32_t s_bpr, uint8_t *d, uint32_t d_bpr,
+                       size_t len, gp_size h)
+{
+	/* Rows are continuous in memory, copy everything at once */
+	if (s_bpr == len && d_bpr == len) {
+		memcpy(d, s, len * h);
+		return;
+	}
+
+	while (h--) {
+		memcpy(d, s, len);
+		s += s_bpr;
+		d += d_bpr;
+	}
+}
+
+/*
+ * Pixels aligned to bytes, each row is a single memcpy(), which is
+ * vectorized in libc for the architecture we are running on.
+ */
+static void blit_bytes(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                       gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	size_t bpp = gp_pixel_size(src->pixel_type)/8;
+	const uint8_t *s = src->pixels + y * src->bytes_per_row + x * bpp;
+	uint8_t *d = dst->pixels + dy * dst->bytes_per_row + dx * bpp;
+
+	copy_bytes(s, src->bytes_per_row, d, dst->bytes_per_row, w * bpp, h);
+}
+
+/*
+ * Packed pixels, e.g. 1bpp and 2bpp e-ink. If the pixels share the position
+ * in the byte in both pixmaps whole bytes are copied and only the partial
+ * bytes at the start and end of the rows go through the generic blit.
+ */
+static void blit_bits(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                      gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	unsigned int bpp = gp_pixel_size(src->pixel_type);
+	unsigned int ppb = 8 / bpp;
+	unsigned int s_bit = (x * bpp + src->offset) % 8;
+	unsigned int d_bit = (dx * bpp + dst->offset) % 8;
+	gp_size head, mid, tail;
+
+	if (s_bit != d_bit) {
+		gp_blit_xywh(src, x, y, w, h, dst, dx, dy);
+		return;
+	}
+
+	head = s_bit ? GP_MIN(w, (8 - s_bit) / bpp) : 0;
+	if (head) {
+		gp_blit_xywh(src, x, y, head, h, dst, dx, dy);
+		x += head;
+		dx += head;
+		w -= head;
+	}
+
+	tail = w % ppb;
+	mid = w - tail;
+
+	if (mid) {
+		const uint8_t *s = src->pixels + y * src->bytes_per_row + (x * bpp + src->offset)/8;
+		uint8_t *d = dst->pixels + dy * dst->bytes_per_row + (dx * bpp + dst->offset)/8;
+
+		copy_bytes(s, src->bytes_per_row, d, dst->bytes_per_row, mid / ppb, h);
+	}
+
+	if (tail)
+		gp_blit_xywh(src, x + mid, y, tail, h, dst, dx + mid, dy);
+}
+
+/*
+ * Maps a pixel coordinate to the physical pixmap memory, i.e. the same
+ * transformation gfxprim does for a rotated pixmap on each pixel access.
+ */
+static uint8_t *phys_addr(gp_pixmap *pixmap, gp_coord x, gp_coord y, size_t bpp)
+{
+	if (pixmap->axes_swap)
+		GP_SWAP(x, y);
+
+	if (pixmap->x_swap)
+		x = pixmap->w - x - 1;
+
+	if (pixmap->y_swap)
+		y = pixmap->h - y - 1;
+
+	return pixmap->pixels + (ptrdiff_t)y * pixmap->bytes_per_row + (ptrdiff_t)x * bpp;
+}
+
+/*
+ * Copies a tile, the pixel size is a constant so that the compiler replaces
+ * the memcpy() with a single load and store, the rows may not be aligned.
+ */
+#define ROTATED_TILE(bpp) do {                                   \
+	for (j = 0; j < th; j++) {                               \
+		const uint8_t *s = s_tile + j * s_bpr;           \
+		uint8_t *d = d_tile + j * step_y;                \
+		for (i = 0; i < tw; i++) {                       \
+			memcpy(d, s, bpp);                        \
+			s += bpp;                                 \
+			d += step_x;                              \
+		}                                                \
+	}                                                        \
+} while (0)
+
+/*
+ * Blits into a rotated pixmap with byte sized pixels.
+ *
+ * Moving by one pixel in the source row is a constant step in the destination
+ * memory, for 90 and 270 degrees it's a step by a whole row. The rectangle is
+ * copied in tiles so that both the source and destination lines of a tile
+ * stay in cache while we transpose it.
+ */
+static void blit_rotated(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                         gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	size_t bpp = gp_pixel_size(src->pixel_type)/8;
+	size_t s_bpr = src->bytes_per_row;
+	const uint8_t *s_start = src->pixels + y * s_bpr + x * bpp;
+	uint8_t *d_start = phys_addr(dst, dx, dy, bpp);
+	ptrdiff_t step_x = phys_addr(dst, dx + 1, dy, bpp) - d_start;
+	ptrdiff_t step_y = phys_addr(dst, dx, dy + 1, bpp) - d_start;
+	gp_size tx, ty, tw, th, i, j;
+
+	for (ty = 0; ty < h; ty += TILE) {
+		th = GP_MIN((gp_size)TILE, h - ty);
+
+		for (tx = 0; tx < w; tx += TILE) {
+			const uint8_t *s_tile = s_start + ty * s_bpr + tx * bpp;
+			uint8_t *d_tile = d_start + ty * step_y + tx * step_x;
+
+			tw = GP_MIN((gp_size)TILE, w - tx);
+
+			switch (bpp) {
+			case 1:
+				ROTATED_TILE(1);
+			break;
+			case 2:
+				ROTATED_TILE(2);
+			break;
+			case 3:
+				ROTATED_TILE(3);
+			break;
+			case 4:
+				ROTATED_TILE(4);
+			break;
+			}
+		}
+	}
+}
+
+void neko_blit_init(gp_pixel_type pixel_type)
+{
+	unsigned int bpp = gp_pixel_size(pixel_type);
+
+	blit_pixel_type = pixel_type;
+
+	switch (bpp) {
+	case 1:
+	case 2:
+	case 4:
+		blit = blit_bits;
+	break;
+	case 8:
+	case 16:
+	case 24:
+	case 32:
+		blit = blit_bytes;
+	break;
+	default:
+		/* Falls back to the generic blit */
+		blit = NULL;
+	}
+
+	GP_DEBUG(1, "Selected %s blit for %ubpp",
+	         blit == blit_bits ? "packed" : (blit == blit_bytes ? "byte" : "generic"),
+	         bpp);
+}
+
+static int is_rotated(const gp_pixmap *pixmap)
+{
+	return pixmap->axes_swap || pixmap->x_swap || pixmap->y_swap;
+}
+
+enum blit_path {
+	BLIT_NONE,
+	BLIT_GENERIC,
+	BLIT_KERNEL,
+};
+
+/*
+ * Decides how to copy the rectangle and clips it to both pixmaps if it's
+ * going to be copied by our kernels.
+ */
+static enum blit_path blit_clip(const gp_pixmap *src, gp_coord x, gp_coord y,
+                                gp_size *w, gp_size *h,
+                                gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	gp_size src_w = gp_pixmap_w(src), src_h = gp_pixmap_h(src);
+	gp_size dst_w = gp_pixmap_w(dst), dst_h = gp_pixmap_h(dst);
+
+	if (!blit || src->pixel_type != blit_pixel_type ||
+	    dst->pixel_type != blit_pixel_type || is_rotated(src) ||
+	    x < 0 || y < 0 || dx < 0 || dy < 0)
+		return BLIT_GENERIC;
+
+	/* Packed pixels are not byte addressable, the tiled copy won't work */
+	if (is_rotated(dst) && blit != blit_bytes)
+		return BLIT_GENERIC;
+
+	if ((gp_size)x >= src_w || (gp_size)y >= src_h ||
+	    (gp_size)dx >= dst_w || (gp_size)dy >= dst_h)
+		return BLIT_NONE;
+
+	*w = GP_MIN(*w, GP_MIN(src_w - x, dst_w - dx));
+	*h = GP_MIN(*h, GP_MIN(src_h - y, dst_h - dy));
+
+	if (!*w || !*h)
+		return BLIT_NONE;
+
+	return BLIT_KERNEL;
+}
+
+static void blit_kernel_run(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                            gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	if (is_rotated(dst))
+		blit_rotated(src, x, y, w, h, dst, dx, dy);
+	else
+		blit(src, x, y, w, h, dst, dx, dy);
+}
+
+void neko_blit(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+               gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	switch (blit_clip(src, x, y, &w, &h, dst, dx, dy)) {
+	case BLIT_GENERIC:
+		gp_blit_xywh_clipped(src, x, y, w, h, dst, dx, dy);
+	break;
+	case BLIT_KERNEL:
+		blit_kernel_run(src, x, y, w, h, dst, dx, dy);
+	break;
+	case BLIT_NONE:
+	break;
+	}
+}
+
+/* Maximal number of blit worker threads */
+#define BLIT_THREADS_MAX 16
+/* Maximal number of blits waiting for a worker */
+#define BLIT_QUEUE 64
+/* Rectangles smaller than that in pixels are not split into bands */
+#define BLIT_BAND_MIN (64 * 1024)
+
+struct blit_job {
+	const gp_pixmap *src;
+	gp_coord x, y;
+	gp_size w, h;
+	gp_pixmap *dst;
+	gp_coord dx, dy;
+};
+
+static struct blit_job jobs[BLIT_QUEUE];
+static unsigned int jobs_first;
+static unsigned int jobs_cnt;
+/* Number of jobs being copied right now */
+static unsigned int jobs_running;
+
+static unsigned int blit_threads;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+static void job_pop(struct blit_job *job)
+{
+	*job = jobs[jobs_first];
+
+	jobs_first = (jobs_first + 1) % BLIT_QUEUE;
+	jobs_cnt--;
+	jobs_running++;
+}
+
+static void job_run(struct blit_job *job)
+{
+	blit_kernel_run(job->src, job->x, job->y, job->w, job->h,
+	                job->dst, job->dx, job->dy);
+}
+
+static void *blit_thread(void *arg)
+{
+	struct blit_job job;
+
+	(void) arg;
+
+	pthread_mutex_lock(&lock);
+
+	for (;;) {
+		while (!jobs_cnt)
+			pthread_cond_wait(&queued, &lock);
+
+		job_pop(&job);
+
+		pthread_mutex_unlock(&lock);
+		job_run(&job);
+		pthread_mutex_lock(&lock);
+
+		if (!--jobs_running)
+			pthread_cond_broadcast(&done);
+	}
+
+	return NULL;
+}
+
+int neko_blit_threads(const char *threads)
+{
+	unsigned long cnt;
+	unsigned int i;
+	char *end;
+
+	if (!strcmp(threads, "no")) {
+		cnt = 0;
+	} else if (!strcmp(threads, "auto")) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		/* The main thread blits as well */
+		cnt = cpus > 1 ? cpus - 1 : 0;
+	} else {
+		errno = 0;
+		cnt = strtoul(threads, &end, 10);
+		if (errno || end == threads || *end)
+			return 1;
+	}
+
+	cnt = GP_MIN(cnt, (unsigned long)BLIT_THREADS_MAX);
+
+	for (i = 0; i < cnt; i++) {
+		pthread_t thread;
+
+		if (pthread_create(&thread, NULL, blit_thread, NULL)) {
+			GP_WARN("Failed to create blit thread");
+			break;
+		}
+
+		pthread_detach(thread);
+	}
+
+	blit_threads = i;
+
+	GP_DEBUG(1, "Started %u blit threads", blit_threads);
+
+	return 0;
+}
+
+void neko_blit_queue(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                     gp_pixmap *dst, gp_coord dx, gp_coord dy)
+{
+	gp_size off, band_h;
+	unsigned int bands;
+
+	/*
+	 * Packed pixels of two rectangles may share a byte, these are
+	 * copied right away so that they don't race on it.
+	 */
+	if (!blit_threads || blit != blit_bytes) {
+		neko_blit(src, x, y, w, h, dst, dx, dy);
+		return;
+	}
+
+	switch (blit_clip(src, x, y, &w, &h, dst, dx, dy)) {
+	case BLIT_GENERIC:
+		gp_blit_xywh_clipped(src, x, y, w, h, dst, dx, dy);
+		return;
+	case BLIT_NONE:
+		return;
+	case BLIT_KERNEL:
+	break;
+	}
+
+	/* Large rectangles are split into bands of rows copied in parallel */
+	bands = GP_MIN(blit_threads + 1, ((uint64_t)w * h) / BLIT_BAND_MIN);
+	bands = GP_MAX(bands, 1u);
+	band_h = (h + bands - 1) / bands;
+
+	pthread_mutex_lock(&lock);
+
+	for (off = 0; off < h; off += band_h) {
+		struct blit_job job = {
+			.src = src,
+			.x = x,
+			.y = y + off,
+			.w = w,
+			.h = GP_MIN(band_h, h - off),
+			.dst = dst,
+			.dx = dx,
+			.dy = dy + off,
+		};
+
+		if (jobs_cnt >= BLIT_QUEUE) {
+			pthread_mutex_unlock(&lock);
+			job_run(&job);
+			pthread_mutex_lock(&lock);
+			continue;
+		}
+
+		jobs[(jobs_first + jobs_cnt) % BLIT_QUEUE] = job;
+		jobs_cnt++;
+	}
+
+	pthread_cond_broadcast(&queued);
+	pthread_mutex_unlock(&lock);
+}
+
+void neko_blit_wait(void)
+{
+	struct blit_job job;
+
+	if (!blit_threads)
+		return;
+
+	pthread_mutex_lock(&lock);
+
+	/* Helps the workers with the rest of the queue */
+	while (jobs_cnt) {
+		job_pop(&job);
+
+		pthread_mutex_unlock(&lock);
+		job_run(&job);
+		pthread_mutex_lock(&lock);
+
+		jobs_running--;
+	}
+
+	while (jobs_running)
+		pthread_cond_wait(&done, &lock);
+
+	pthread_mutex_unlock(&lock);
+}
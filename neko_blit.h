@@ -0,0 +1,82 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A compositor blit.
+ * @file neko_blit.h
+ *
+ * The app SHM pixmaps are always allocated with the backend pixmap pixel type
+ * so the compositor does not need a generic blit that converts pixels. The
+ * blit kernel is selected once based on the pixel size.
+ */
+
+#ifndef NEKO_BLIT_H
+#define NEKO_BLIT_H
+
+#include <core/gp_types.h>
+
+/**
+ * @brief Selects a blit kernel for a pixel type.
+ *
+ * @param pixel_type A backend pixel type.
+ */
+void neko_blit_init(gp_pixel_type pixel_type);
+
+/**
+ * @brief Copies a rectangle between two pixmaps.
+ *
+ * The rectangle is clipped to both pixmaps. If the destination pixmap is
+ * rotated the rectangle is rotated in the same pass while being copied. If
+ * the pixmaps differ in pixel type, the source is rotated, or the destination
+ * is rotated and has pixels smaller than a byte the generic gfxprim blit is
+ * used.
+ *
+ * @param src A source pixmap.
+ * @param x A x offset in the source pixmap.
+ * @param y A y offset in the source pixmap.
+ * @param w A rectangle width.
+ * @param h A rectangle height.
+ * @param dst A destination pixmap.
+ * @param dx A x offset in the destination pixmap.
+ * @param dy A y offset in the destination pixmap.
+ */
+void neko_blit(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+               gp_pixmap *dst, gp_coord dx, gp_coord dy);
+
+/**
+ * @brief Starts the blit worker threads.
+ *
+ * @param threads Either "no", "auto" to start a thread per additional CPU
+ *                core, or a number of threads.
+ *
+ * @return Zero on success, non-zero if threads is invalid.
+ */
+int neko_blit_threads(const char *threads);
+
+/**
+ * @brief Queues a rectangle copy for the blit worker threads.
+ *
+ * Large rectangles are split into bands of rows that are copied in parallel.
+ * The pixmaps must not be changed until neko_blit_wait() returns. Without the
+ * worker threads, or for pixels smaller than a byte, the rectangle is copied
+ * right away.
+ *
+ * The parameters are the same as for neko_blit().
+ */
+void neko_blit_queue(const gp_pixmap *src, gp_coord x, gp_coord y, gp_size w, gp_size h,
+                     gp_pixmap *dst, gp_coord dx, gp_coord dy);
+
+/**
+ * @brief Waits for all queued rectangles to be copied.
+ *
+ * The calling thread copies the rectangles that have not been picked up by
+ * the workers yet. Called by neko_flush() as well before the damage is read
+ * from the pixmap, so that the flushing never sees a half blitted rectangle.
+ */
+void neko_blit_wait(void);
+
+#endif /* NEKO_BLIT_H */
@@ -0,0 +1,39 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <stddef.h>
+
+#include "neko_config.h"
+
+/* The ids are looked up by a binary search, keep them sorted! */
+struct gp_json_struct neko_config_desc[] = {
+	GP_JSON_SERDES_STR_CPY(struct neko_config, backend_opts, GP_JSON_SERDES_OPTIONAL, 256),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, blit_threads, GP_JSON_SERDES_OPTIONAL, 8),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, eink, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, eink_idle, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, eink_partial_max, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, flush_cost, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, flush_diff, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, font_family, GP_JSON_SERDES_OPTIONAL, 256),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, frame_rate, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, motion_coalesce, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, motion_raw_apps, GP_JSON_SERDES_OPTIONAL, 128),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, rotate, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, shm_pool_apps, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, shm_pool_mem, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, shm_prefault, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, snapshot_mem, GP_JSON_SERDES_OPTIONAL, 16),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, snapshot_rle, GP_JSON_SERDES_OPTIONAL, 4),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, theme, GP_JSON_SERDES_OPTIONAL, 64),
+	GP_JSON_SERDES_STR_CPY(struct neko_config, update_ack, GP_JSON_SERDES_OPTIONAL, 16),
+	{}
+};
+
+int neko_config_load(const char *path, struct neko_config *cfg)
+{
+	return gp_json_load_struct(path, neko_config_desc, cfg);
+}
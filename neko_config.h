@@ -0,0 +1,60 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A nekowm config file.
+ * @file neko_config.h
+ */
+
+#ifndef NEKO_CONFIG_H
+#define NEKO_CONFIG_H
+
+#include <utils/gp_json_serdes.h>
+
+/** @brief Config options, all of them are stored as strings. */
+struct neko_config {
+	char backend_opts[256];
+	char font_family[256];
+	char rotate[4];
+	char theme[64];
+	char frame_rate[16];
+	char update_ack[16];
+	char shm_pool_apps[16];
+	char shm_pool_mem[16];
+	char snapshot_mem[16];
+	char snapshot_rle[4];
+	char shm_prefault[4];
+	char flush_diff[4];
+	char flush_cost[16];
+	char blit_threads[8];
+	char eink[4];
+	char eink_partial_max[16];
+	char eink_idle[16];
+	char motion_coalesce[4];
+	char motion_raw_apps[128];
+};
+
+/**
+ * @brief A config file description.
+ *
+ * The entries are sorted by id, terminated by an entry with NULL id.
+ */
+extern struct gp_json_struct neko_config_desc[];
+
+/**
+ * @brief Loads a config file.
+ *
+ * Only options that are present in the file are changed in the cfg.
+ *
+ * @param path A path to the config file.
+ * @param cfg A config to load the options into.
+ *
+ * @return Zero on success, non-zero on a failure.
+ */
+int neko_config_load(const char *path, struct neko_config *cfg);
+
+#endif /* NEKO_CONFIG_H */
@@ -0,0 +1,45 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <core/gp_core.h>
+#include <backends/gp_backend.h>
+
+#include "neko_ctx.h"
+#include "neko_damage.h"
+#include "neko_flush.h"
+
+static neko_region damage;
+
+void neko_damage_add(const neko_rect *rect)
+{
+	gp_pixmap *pixmap = ctx.backend->pixmap;
+	neko_rect screen = {
+		.w = gp_pixmap_w(pixmap),
+		.h = gp_pixmap_h(pixmap),
+	};
+	neko_rect r;
+
+	if (!neko_rect_intersect(&r, rect, &screen))
+		return;
+
+	neko_region_add(&damage, &r);
+}
+
+int neko_damage_pending(void)
+{
+	return !neko_region_is_empty(&damage);
+}
+
+void neko_damage_flush(void)
+{
+	neko_flush(&damage, 0);
+}
+
+void neko_damage_flush_full(void)
+{
+	neko_flush(&damage, 1);
+}
@@ -0,0 +1,52 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A screen damage accumulator.
+ * @file neko_damage.h
+ *
+ * All screen updates are collected into a single region during a main loop
+ * iteration and the region is flushed to the backend once at the end of the
+ * iteration.
+ */
+
+#ifndef NEKO_DAMAGE_H
+#define NEKO_DAMAGE_H
+
+#include "neko_region.h"
+
+/**
+ * @brief Adds a rectangle to the screen damage.
+ *
+ * The rectangle is clipped to the backend pixmap size.
+ *
+ * @param rect A rectangle in the backend pixmap coordinates.
+ */
+void neko_damage_add(const neko_rect *rect);
+
+/**
+ * @brief Returns true if there is anything to flush.
+ *
+ * @return Non-zero if damage is not empty.
+ */
+int neko_damage_pending(void);
+
+/**
+ * @brief Flushes the damage to the backend.
+ *
+ * Updates all damaged rectangles on the screen and clears the damage.
+ */
+void neko_damage_flush(void);
+
+/**
+ * @brief Refreshes the whole screen.
+ *
+ * Clears the damage. Does a full refresh on e-ink displays.
+ */
+void neko_damage_flush_full(void);
+
+#endif /* NEKO_DAMAGE_H */
@@ -0,0 +1,136 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <string.h>
+
+#include <core/gp_core.h>
+#include <backends/gp_backend.h>
+
+#include "neko_ctx.h"
+#include "neko_damage.h"
+#include "neko_frame.h"
+#include "neko_eink.h"
+
+/* The screen is divided into EINK_TILES x EINK_TILES tiles */
+#define EINK_TILES 8
+/* Updates are batched for at least EINK_BATCH ms */
+#define EINK_BATCH 100
+/* Updates covering more than EINK_FULL_AREA percent of the screen */
+#define EINK_FULL_AREA 50
+
+static int eink_enabled;
+static unsigned int eink_partial_max;
+static uint16_t partial_cnt[EINK_TILES][EINK_TILES];
+
+static uint32_t idle_callback(gp_timer *self);
+
+static gp_timer idle_timer = {
+	.id = "E-ink idle",
+	.callback = idle_callback,
+};
+
+static int idle_running;
+
+static uint32_t idle_callback(gp_timer *self)
+{
+	(void)self;
+
+	idle_running = 0;
+
+	GP_DEBUG(2, "E-ink idle full refresh");
+
+	neko_damage_flush_full();
+
+	return 0;
+}
+
+void neko_eink_init(unsigned int partial_max, uint32_t idle_timeout)
+{
+	GP_DEBUG(1, "E-ink partial refreshes max %u idle timeout %ums",
+	         partial_max, idle_timeout);
+
+	eink_enabled = 1;
+	eink_partial_max = partial_max;
+	idle_timer.expires = idle_timeout;
+
+	neko_frame_delay(EINK_BATCH);
+}
+
+static void idle_stop(void)
+{
+	if (!idle_running)
+		return;
+
+	gp_backend_timer_stop(ctx.backend, &idle_timer);
+	idle_running = 0;
+}
+
+static void idle_restart(void)
+{
+	if (!idle_timer.expires)
+		return;
+
+	idle_stop();
+
+	gp_backend_timer_start(ctx.backend, &idle_timer);
+	idle_running = 1;
+}
+
+/* Returns non-zero if the region should be refreshed fully */
+static int count_partial(const neko_region *region)
+{
+	gp_size w = gp_pixmap_w(ctx.backend->pixmap);
+	gp_size h = gp_pixmap_h(ctx.backend->pixmap);
+	size_t area = 0;
+	unsigned int i, tx, ty;
+	int ret = 0;
+
+	for (i = 0; i < region->cnt; i++) {
+		const neko_rect *r = &region->rects[i];
+		unsigned int tx0 = r->x * EINK_TILES / w;
+		unsigned int tx1 = (r->x + r->w - 1) * EINK_TILES / w;
+		unsigned int ty0 = r->y * EINK_TILES / h;
+		unsigned int ty1 = (r->y + r->h - 1) * EINK_TILES / h;
+
+		for (ty = ty0; ty <= ty1; ty++) {
+			for (tx = tx0; tx <= tx1; tx++) {
+				if (++partial_cnt[ty][tx] >= eink_partial_max)
+					ret = 1;
+			}
+		}
+
+		area += neko_rect_area(r);
+	}
+
+	if (area * 100 >= (size_t)w * h * EINK_FULL_AREA)
+		ret = 1;
+
+	return ret;
+}
+
+int neko_eink_refresh(const neko_region *region, int full)
+{
+	if (!eink_enabled)
+		return full;
+
+	if (!full && neko_region_is_empty(region))
+		return 0;
+
+	if (!full)
+		full = count_partial(region);
+
+	if (full) {
+		memset(partial_cnt, 0, sizeof(partial_cnt));
+		idle_stop();
+		return 1;
+	}
+
+	/* Clean up the ghosting once the screen is idle */
+	idle_restart();
+
+	return 0;
+}
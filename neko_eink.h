@@ -0,0 +1,48 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief An e-ink refresh scheduler.
+ * @file neko_eink.h
+ *
+ * E-ink displays accumulate ghosting with each partial refresh, which has to
+ * be cleaned up by a full refresh from time to time. The scheduler batches
+ * the updates, counts partial refreshes for each tile of the screen and
+ * requests a full refresh once any of the tiles has been partially refreshed
+ * too many times, when a large part of the screen changes at once or when
+ * the screen is idle after a partial refresh.
+ */
+
+#ifndef NEKO_EINK_H
+#define NEKO_EINK_H
+
+#include <stdint.h>
+#include "neko_region.h"
+
+/**
+ * @brief Enables the e-ink scheduler.
+ *
+ * @param partial_max A maximal number of partial refreshes of a screen tile
+ *                    before a full refresh is done.
+ * @param idle_timeout A time in ms after the last partial refresh after which
+ *                     a full refresh is done, zero disables it.
+ */
+void neko_eink_init(unsigned int partial_max, uint32_t idle_timeout);
+
+/**
+ * @brief Decides between a partial and a full refresh.
+ *
+ * Called for each damage region before it is flushed.
+ *
+ * @param region A region to be flushed.
+ * @param full Set if a full refresh has been requested.
+ *
+ * @return Non-zero if full refresh should be done.
+ */
+int neko_eink_refresh(const neko_region *region, int full);
+
+#endif /* NEKO_EINK_H */
@@ -0,0 +1,366 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/gp_core.h>
+#include <core/gp_transform.h>
+#include <backends/gp_backend.h>
+
+#include "neko_ctx.h"
+#include "neko_blit.h"
+#include "neko_eink.h"
+#include "neko_view.h"
+#include "neko_view_app.h"
+#include "neko_flush.h"
+
+/* A copy of the content flushed to the display, used to skip unchanged areas */
+static gp_pixmap *flushed;
+/* A per rectangle flush setup cost in pixels */
+static uint64_t merge_setup;
+
+/*
+ * Copies a rectangle in physical coordinates between pixmaps of the same
+ * physical size, partial bytes on the edges are copied as whole.
+ */
+static void copy_phys(gp_pixmap *dst, gp_pixmap *src,
+                      gp_coord x, gp_coord y, gp_size w, gp_size h)
+{
+	size_t bpp = gp_pixel_size(src->pixel_type);
+	size_t x0 = (x * bpp)/8;
+	size_t x1 = ((x + w) * bpp + 7)/8;
+	uint8_t *src_row = src->pixels + y * src->bytes_per_row + x0;
+	uint8_t *dst_row = dst->pixels + y * dst->bytes_per_row + x0;
+	gp_size i;
+
+	for (i = 0; i < h; i++) {
+		memcpy(dst_row, src_row, x1 - x0);
+		src_row += src->bytes_per_row;
+		dst_row += dst->bytes_per_row;
+	}
+}
+
+/* Inverse to GP_TRANSFORM_RECT() */
+static void untransform_rect(gp_pixmap *pixmap, gp_coord *x, gp_coord *y,
+                             gp_size *w, gp_size *h)
+{
+	if (pixmap->x_swap)
+		*x = pixmap->w - *x - *w;
+
+	if (pixmap->y_swap)
+		*y = pixmap->h - *y - *h;
+
+	if (pixmap->axes_swap) {
+		GP_SWAP(*x, *y);
+		GP_SWAP(*w, *h);
+	}
+}
+
+/* Returns offset of the first differing byte, rows are known to differ */
+static size_t first_diff(const uint8_t *a, const uint8_t *b, size_t len)
+{
+	uint64_t va, vb;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		memcpy(&va, a + i, 8);
+		memcpy(&vb, b + i, 8);
+		if (va != vb)
+			break;
+	}
+
+	while (a[i] == b[i])
+		i++;
+
+	return i;
+}
+
+/* Returns offset after the last differing byte, rows are known to differ */
+static size_t last_diff(const uint8_t *a, const uint8_t *b, size_t len)
+{
+	uint64_t va, vb;
+	size_t i;
+
+	for (i = len; i >= 8; i -= 8) {
+		memcpy(&va, a + i - 8, 8);
+		memcpy(&vb, b + i - 8, 8);
+		if (va != vb)
+			break;
+	}
+
+	while (a[i-1] == b[i-1])
+		i--;
+
+	return i;
+}
+
+/*
+ * Shrinks the rectangle to the bounding box of the pixels that differ from
+ * the content that has been flushed already and updates the copy.
+ *
+ * Returns zero if nothing has changed.
+ */
+static int diff_rect(neko_rect *r)
+{
+	gp_pixmap *src = ctx.backend->pixmap;
+	gp_coord x = r->x, y = r->y;
+	gp_size w = r->w, h = r->h;
+	size_t bpp = gp_pixel_size(src->pixel_type);
+
+	GP_TRANSFORM_RECT(src, x, y, w, h);
+
+	size_t x0 = (x * bpp)/8;
+	size_t len = ((x + w) * bpp + 7)/8 - x0;
+	size_t min = len, max = 0;
+	gp_size i, top = h, bottom = 0;
+
+	for (i = 0; i < h; i++) {
+		const uint8_t *a = src->pixels + (y + i) * src->bytes_per_row + x0;
+		const uint8_t *b = flushed->pixels + (y + i) * flushed->bytes_per_row + x0;
+
+		/* The libc memcmp() is vectorized */
+		if (!memcmp(a, b, len))
+			continue;
+
+		min = GP_MIN(min, first_diff(a, b, len));
+		max = GP_MAX(max, last_diff(a, b, len));
+
+		if (top == h)
+			top = i;
+
+		bottom = i + 1;
+	}
+
+	if (top == h)
+		return 0;
+
+	copy_phys(flushed, src, x, y + top, w, bottom - top);
+
+	gp_coord px0 = GP_MAX((gp_coord)((x0 + min) * 8 / bpp), x);
+	gp_coord px1 = GP_MIN((gp_coord)(((x0 + max) * 8 + bpp - 1) / bpp), (gp_coord)(x + w));
+
+	x = px0;
+	w = px1 - px0;
+	y += top;
+	h = bottom - top;
+
+	untransform_rect(src, &x, &y, &w, &h);
+
+	r->x = x;
+	r->y = y;
+	r->w = w;
+	r->h = h;
+
+	return 1;
+}
+
+/* Drops unchanged rectangles and shrinks the rest to the changed pixels */
+static void diff_region(neko_region *region)
+{
+	unsigned int i, j = 0;
+
+	for (i = 0; i < region->cnt; i++) {
+		neko_rect *r = &region->rects[i];
+
+		if (!diff_rect(r)) {
+			GP_DEBUG(4, "Skipping unchanged rect %ix%i-%ux%u",
+			         r->x, r->y, r->w, r->h);
+			continue;
+		}
+
+		region->rects[j++] = *r;
+	}
+
+	region->cnt = j;
+}
+
+/* Shrinks the damage to the pixels that have changed and merges it */
+static void flush_prepare(neko_region *region, int full)
+{
+	gp_pixmap *pixmap = ctx.backend->pixmap;
+
+	if (full) {
+		if (flushed)
+			copy_phys(flushed, pixmap, 0, 0, pixmap->w, pixmap->h);
+		return;
+	}
+
+	if (flushed)
+		diff_region(region);
+
+	neko_region_merge(region, merge_setup);
+}
+
+/* Sends the prepared damage to the display */
+static void flush_send(neko_region *region, int full)
+{
+	unsigned int i;
+
+	if (full) {
+		GP_DEBUG(4, "Flushing whole screen");
+		gp_backend_flip(ctx.backend);
+		return;
+	}
+
+	for (i = 0; i < region->cnt; i++) {
+		neko_rect *r = &region->rects[i];
+
+		GP_DEBUG(4, "Flushing rect %ix%i-%ux%u", r->x, r->y, r->w, r->h);
+
+		gp_backend_update_rect_xywh(ctx.backend, r->x, r->y, r->w, r->h);
+	}
+}
+
+/* The copy starts with the content that is on the display now */
+static gp_pixmap *flushed_alloc(void)
+{
+	gp_pixmap *pixmap = ctx.backend->pixmap;
+	gp_pixmap *ret;
+
+	ret = gp_pixmap_alloc(pixmap->w, pixmap->h, pixmap->pixel_type);
+	if (!ret)
+		return NULL;
+
+	ret->axes_swap = pixmap->axes_swap;
+	ret->x_swap = pixmap->x_swap;
+	ret->y_swap = pixmap->y_swap;
+
+	copy_phys(ret, pixmap, 0, 0, pixmap->w, pixmap->h);
+
+	return ret;
+}
+
+void neko_flush_init(int diff)
+{
+	if (!diff)
+		return;
+
+	flushed = flushed_alloc();
+	if (flushed)
+		GP_DEBUG(1, "Skipping unchanged damage");
+	else
+		GP_WARN("Failed to allocate flushed pixmap copy");
+}
+
+void neko_flush(neko_region *region, int full)
+{
+	full = neko_eink_refresh(region, full);
+
+	/* The blit threads write into the backend pixmap */
+	neko_blit_wait();
+
+	flush_prepare(region, full);
+	flush_send(region, full);
+	neko_region_clear(region);
+
+	neko_view_app_presented();
+}
+
+static uint64_t time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#define CALIBRATE_RUNS 4
+
+static uint64_t time_update(gp_size w, gp_size h)
+{
+	uint64_t start = time_ns();
+	int i;
+
+	for (i = 0; i < CALIBRATE_RUNS; i++)
+		gp_backend_update_rect_xywh(ctx.backend, 0, 0, w, h);
+
+	return (time_ns() - start) / CALIBRATE_RUNS;
+}
+
+/*
+ * Measures how long it takes to flush a single pixel and a quarter of the
+ * screen, the difference is the cost of the pixels, the rest is the setup.
+ */
+static uint64_t calibrate(void)
+{
+	gp_size w = gp_pixmap_w(ctx.backend->pixmap);
+	gp_size h = GP_MAX(gp_pixmap_h(ctx.backend->pixmap) / 4, 1u);
+	uint64_t t_pixel = time_update(1, 1);
+	uint64_t t_big = time_update(w, h);
+	uint64_t pixels = (uint64_t)w * h;
+
+	GP_DEBUG(1, "Flushing 1 pixel %luns %lu pixels %luns",
+	         (unsigned long)t_pixel, (unsigned long)pixels, (unsigned long)t_big);
+
+	if (t_big <= t_pixel)
+		return 0;
+
+	return t_pixel * (pixels - 1) / (t_big - t_pixel);
+}
+
+int neko_flush_cost(const char *cost)
+{
+	unsigned long long setup;
+	char *end;
+
+	if (!cost[0])
+		return 0;
+
+	if (!strcmp(cost, "auto")) {
+		merge_setup = calibrate();
+		goto ret;
+	}
+
+	/* The strtoull() would silently negate a number with a minus sign */
+	if (!isdigit((unsigned char)*cost))
+		return 1;
+
+	errno = 0;
+	setup = strtoull(cost, &end, 10);
+	if (errno || *end)
+		return 1;
+
+	merge_setup = setup * 8 / gp_pixel_size(ctx.backend->pixmap->pixel_type);
+ret:
+	GP_DEBUG(1, "Flush setup cost %lu pixels", (unsigned long)merge_setup);
+	return 0;
+}
+
+void neko_flush_resync(void)
+{
+	gp_pixmap *pixmap = ctx.backend->pixmap;
+
+	if (!flushed)
+		return;
+
+	copy_phys(flushed, pixmap, 0, 0, pixmap->w, pixmap->h);
+}
+
+void neko_flush_rotate_cw(void)
+{
+	gp_pixmap_rotate_cw(ctx.backend->pixmap);
+
+	if (flushed)
+		gp_pixmap_rotate_cw(flushed);
+}
+
+void neko_flush_resize(void)
+{
+	if (!flushed)
+		return;
+
+	gp_pixmap_free(flushed);
+
+	flushed = flushed_alloc();
+	if (!flushed)
+		GP_WARN("Failed to reallocate flushed pixmap copy");
+}
@@ -0,0 +1,90 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief Flushes the screen damage to the display.
+ * @file neko_flush.h
+ *
+ * The damage is sent to the display from the main loop, which blocks it for
+ * the whole transfer on slow displays, e.g. SPI panels or e-ink. The gfxprim
+ * backends are not thread safe, so the transfer cannot be moved into a thread
+ * while the main loop waits for events in the backend.
+ *
+ * Optionally the damage is compared against a copy of the content that has
+ * been flushed and shrunk to the pixels that have changed and the rectangles
+ * are merged according to a cost model.
+ */
+
+#ifndef NEKO_FLUSH_H
+#define NEKO_FLUSH_H
+
+#include "neko_region.h"
+
+/**
+ * @brief Initializes the flushing.
+ *
+ * Has to be called after neko_ctx_init() and after the backend pixmap has
+ * been rotated.
+ *
+ * @param diff If non-zero a copy of the flushed content is kept and the
+ *             damage is shrunk to the pixels that have actually changed
+ *             before it is flushed. Saves bus bandwidth on SPI and e-ink
+ *             displays at the cost of a compare pass and a copy of the
+ *             screen.
+ */
+void neko_flush_init(int diff);
+
+/**
+ * @brief Sets up the cost model for merging the damage before it's flushed.
+ *
+ * Flushing a rectangle costs a constant setup, e.g. a SPI transaction, plus
+ * a cost per byte. Rectangles are merged into their bounding box if flushing
+ * the extra pixels is cheaper than the setup of an extra rectangle.
+ *
+ * @param cost An empty string disables merging, "auto" measures the costs by
+ *             flushing parts of the screen, otherwise a setup cost expressed
+ *             as a number of bytes that could be transferred in that time.
+ *             The "auto" flushes the backend pixmap so it should be called
+ *             once the screen content is in place.
+ *
+ * @return Zero on success, non-zero if cost is invalid.
+ */
+int neko_flush_cost(const char *cost);
+
+/**
+ * @brief Flushes the region and clears it.
+ *
+ * Waits for the blit threads before the backend pixmap is read and calls
+ * neko_view_app_presented() once the damage has been sent to the display.
+ *
+ * @param region A damaged region.
+ * @param full If set the whole screen is refreshed with gp_backend_flip(),
+ *             which does a full refresh on e-ink displays. May be set by
+ *             the e-ink scheduler as well.
+ */
+void neko_flush(neko_region *region, int full);
+
+/**
+ * @brief Updates the copy of the flushed content from the backend pixmap.
+ *
+ * Has to be called after the backend pixmap has been flushed without
+ * neko_flush(), e.g. with gp_backend_flip(), otherwise the damage would be
+ * compared against stale content.
+ */
+void neko_flush_resync(void);
+
+/**
+ * @brief Rotates the backend pixmap and the flushed content copy clockwise.
+ */
+void neko_flush_rotate_cw(void);
+
+/**
+ * @brief Reallocates the flushed content copy after the backend was resized.
+ */
+void neko_flush_resize(void);
+
+#endif /* NEKO_FLUSH_H */
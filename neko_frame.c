@@ -0,0 +1,144 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <time.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <core/gp_core.h>
+#include <backends/gp_backend.h>
+#include <backends/gp_proxy_cli.h>
+
+#include "neko_ctx.h"
+#include "neko_damage.h"
+#include "neko_view.h"
+#include "neko_view_app.h"
+#include "neko_frame.h"
+
+/* Limits for the adaptive frame interval in ms */
+#define ADAPTIVE_MIN 16
+#define ADAPTIVE_MAX 1000
+
+/* Frame interval in ms, zero means present on each loop iteration */
+static uint32_t frame_interval;
+/* Minimal delay between the damage and its presentation in ms */
+static uint32_t frame_delay;
+static int frame_adaptive;
+static uint64_t last_present;
+static int timer_running;
+
+static uint32_t frame_timer_callback(gp_timer *self);
+
+static gp_timer frame_timer = {
+	.id = "Frame timer",
+	.callback = frame_timer_callback,
+};
+
+uint64_t neko_frame_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int neko_frame_init(const char *frame_rate)
+{
+	char *end;
+	long rate;
+
+	if (!frame_rate[0])
+		return 0;
+
+	if (!strcmp(frame_rate, "adaptive")) {
+		frame_adaptive = 1;
+		frame_interval = ADAPTIVE_MIN;
+		GP_DEBUG(1, "Adaptive frame rate");
+		return 0;
+	}
+
+	rate = strtol(frame_rate, &end, 10);
+	if (*end || rate <= 0 || rate > 1000)
+		return 1;
+
+	frame_interval = 1000 / rate;
+
+	GP_DEBUG(1, "Frame rate %liHz interval %ums", rate, frame_interval);
+
+	return 0;
+}
+
+static void present(void)
+{
+	uint64_t start = neko_frame_time();
+
+	neko_damage_flush();
+
+	last_present = neko_frame_time();
+
+	/*
+	 * Slow displays, e.g. e-ink, block in the flush, in that case we
+	 * collect the damage for as long as the last flush took.
+	 */
+	if (frame_adaptive) {
+		uint64_t took = last_present - start;
+
+		frame_interval = GP_MIN(GP_MAX(took, (uint64_t)ADAPTIVE_MIN),
+		                        (uint64_t)ADAPTIVE_MAX);
+	}
+}
+
+static uint32_t frame_timer_callback(gp_timer *self)
+{
+	(void)self;
+
+	timer_running = 0;
+
+	if (neko_damage_pending())
+		present();
+
+	return 0;
+}
+
+void neko_frame_delay(uint32_t delay)
+{
+	GP_DEBUG(1, "Frame delay %ums", delay);
+
+	frame_delay = delay;
+}
+
+void neko_frame_schedule(void)
+{
+	uint64_t elapsed;
+
+	/* Nothing to present, ack updates that were flushed elsewhere */
+	if (!neko_damage_pending()) {
+		neko_view_app_presented();
+		return;
+	}
+
+	if (!frame_interval && !frame_delay) {
+		present();
+		return;
+	}
+
+	if (timer_running)
+		return;
+
+	elapsed = neko_frame_time() - last_present;
+
+	if (elapsed >= frame_interval && !frame_delay) {
+		present();
+		return;
+	}
+
+	frame_timer.expires = elapsed < frame_interval ? frame_interval - elapsed : 0;
+	frame_timer.expires = GP_MAX(frame_timer.expires, frame_delay);
+	gp_backend_timer_start(ctx.backend, &frame_timer);
+	timer_running = 1;
+}
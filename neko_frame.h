@@ -0,0 +1,61 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A compositor frame clock.
+ * @file neko_frame.h
+ *
+ * The frame clock limits how often is the screen damage flushed to the
+ * backend. Damage is collected during the frame interval and presented at
+ * most once per frame, frames with no damage are skipped.
+ */
+
+#ifndef NEKO_FRAME_H
+#define NEKO_FRAME_H
+
+#include <stdint.h>
+
+/**
+ * @brief Initializes the frame clock.
+ *
+ * @param frame_rate A frame rate in Hz, "adaptive" to derive the frame
+ *                   interval from the time the backend takes to flush, or an
+ *                   empty string to present the damage on each main loop
+ *                   iteration.
+ *
+ * @return Zero on success, non-zero if frame_rate is invalid.
+ */
+int neko_frame_init(const char *frame_rate);
+
+/**
+ * @brief Sets a minimal delay between the damage and its presentation.
+ *
+ * Allows to batch updates that arrive shortly after each other, e.g. for
+ * e-ink displays where each refresh is slow and visible.
+ *
+ * @param delay A delay in ms.
+ */
+void neko_frame_delay(uint32_t delay);
+
+/**
+ * @brief Presents the damage or schedules the presentation.
+ *
+ * Called from the main loop after all events were processed. If the frame
+ * interval has elapsed since the last presentation the damage is flushed
+ * right away, otherwise a timer is started to flush it at the start of the
+ * next frame.
+ */
+void neko_frame_schedule(void);
+
+/**
+ * @brief Returns a monotonic time stamp.
+ *
+ * @return A time in milliseconds.
+ */
+uint64_t neko_frame_time(void);
+
+#endif /* NEKO_FRAME_H */
@@ -79,23 +79,75 @@ static struct run apps[RUN_MAX] = {
 };
 static unsigned int apps_cnt = 1;
 
+/*
+ * Key value to keybinding and run table lookup tables, rebuilt when the
+ * keybindings are loaded. Stored as index + 1 so that zero means no binding.
+ */
+#define KEYMAP_SIZE 0x300
+
+static uint8_t keymap[KEYMAP_SIZE];
+static uint8_t runmap[KEYMAP_SIZE];
+
+/*
+ * Only the WM actions are dispatched by the lookup, the rest of the
+ * keybindings are handled by the views and may share keys with these. Listed
+ * in the order of precedence in a case that two actions share a key.
+ */
+static const uint8_t wm_actions[] = {
+	NEKO_KEYS_EXIT_IDX,
+	NEKO_KEYS_POWEROFF_IDX,
+	NEKO_KEYS_VIRT_SCREENS_LEFT_IDX,
+	NEKO_KEYS_VIRT_SCREENS_RIGHT_IDX,
+	NEKO_KEYS_ROTATE_IDX,
+};
+
+static void compile_keymap(void)
+{
+	int i;
+
+	memset(keymap, 0, sizeof(keymap));
+	memset(runmap, 0, sizeof(runmap));
+
+	/* Filled backwards so that the first binding for a key wins */
+	for (i = GP_ARRAY_SIZE(wm_actions) - 1; i >= 0; i--) {
+		uint32_t key = neko_keybindings[wm_actions[i]].key;
+
+		if (key < KEYMAP_SIZE)
+			keymap[key] = wm_actions[i] + 1;
+	}
+
+	for (i = apps_cnt - 1; i >= 0; i--) {
+		if (apps[i].key < KEYMAP_SIZE)
+			runmap[apps[i].key] = i + 1;
+	}
+}
+
+int neko_keybindings_lookup(uint32_t key)
+{
+	if (key >= KEYMAP_SIZE)
+		return -1;
+
+	return (int)keymap[key] - 1;
+}
+
 int neko_process_keybindings(uint32_t key)
 {
-	unsigned int i;
-
-	for (i = 0; i < apps_cnt; i++) {
-		if (apps[i].key == key) {
-			switch (apps[i].type) {
-			case RUN_APP:
-				neko_app_run(apps[i].app_name);
-				return 1;
-			case RUN_CMD:
-				neko_cmd_run(apps[i].cmdline);
-				return 1;
-			default:
-			break;
-			}
-		}
+	struct run *app;
+
+	if (key >= KEYMAP_SIZE || !runmap[key])
+		return 0;
+
+	app = &apps[runmap[key] - 1];
+
+	switch (app->type) {
+	case RUN_APP:
+		neko_app_run(app->app_name);
+		return 1;
+	case RUN_CMD:
+		neko_cmd_run(app->cmdline);
+		return 1;
+	default:
+	break;
 	}
 
 	return 0;
@@ -175,7 +227,7 @@ static void parse_run_app(gp_json_reader *json, gp_json_val *val, enum run_type
 	apps_cnt++;
 }
 
-void neko_load_keybindings(void)
+static void load_keybindings(void)
 {
 	char *path = gp_user_path(".config/nekowm/", "keybindings.json");
 	gp_json_reader *json;
@@ -222,3 +274,9 @@ err:
 	gp_json_reader_free(json);
 	free(path);
 }
+
+void neko_load_keybindings(void)
+{
+	load_keybindings();
+	compile_keymap();
+}
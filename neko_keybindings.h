@@ -101,9 +101,22 @@ enum neko_keybindings_idx {
 
 /**
  * @brief Loads keybindings from a file.
+ *
+ * Also builds the key lookup tables.
  */
 void neko_load_keybindings(void);
 
+/**
+ * @brief Looks up a WM action keybinding for a key.
+ *
+ * Only exit, poweroff, virtual screens left and right and rotate are looked
+ * up, the rest of the keybindings are matched by the views.
+ *
+ * @param key A key that was pressed.
+ * @return A keybinding index or -1 if there is none.
+ */
+int neko_keybindings_lookup(uint32_t key);
+
 /**
  * @brief Processes global keybindings.
  *
@@ -0,0 +1,162 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <core/gp_common.h>
+#include <core/gp_debug.h>
+
+#include "neko_prefault.h"
+
+/* Older libc headers may miss it, older kernels return EINVAL */
+#ifndef MADV_POPULATE_WRITE
+# define MADV_POPULATE_WRITE 23
+#endif
+
+/* Maximal number of mappings waiting to be populated */
+#define PREFAULT_QUEUE 16
+/* The mapping is populated in chunks so that it can be canceled */
+#define PREFAULT_CHUNK (1024 * 1024)
+
+struct prefault_req {
+	char *addr;
+	size_t size;
+	size_t off;
+};
+
+static struct prefault_req queue[PREFAULT_QUEUE];
+static unsigned int queue_len;
+
+/* The mapping the thread is populating right now */
+static void *busy_addr;
+
+static int prefault_enabled;
+static int prefault_unsupported;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+static void queue_rem(unsigned int i)
+{
+	queue_len--;
+	memmove(&queue[i], &queue[i+1], (queue_len - i) * sizeof(*queue));
+}
+
+static void queue_cancel(void *addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < queue_len; i++) {
+		if (queue[i].addr == addr)
+			queue_rem(i--);
+	}
+}
+
+static void *prefault_thread(void *unused)
+{
+	(void) unused;
+
+	pthread_mutex_lock(&lock);
+
+	for (;;) {
+		while (!queue_len)
+			pthread_cond_wait(&queued, &lock);
+
+		struct prefault_req *req = &queue[0];
+		char *addr = req->addr + req->off;
+		size_t chunk = GP_MIN((size_t)PREFAULT_CHUNK, req->size - req->off);
+		int ret;
+
+		req->off += chunk;
+		busy_addr = req->addr;
+
+		if (req->off >= req->size)
+			queue_rem(0);
+
+		pthread_mutex_unlock(&lock);
+
+		ret = madvise(addr, chunk, MADV_POPULATE_WRITE);
+
+		pthread_mutex_lock(&lock);
+
+		if (ret && errno == EINVAL) {
+			GP_WARN("MADV_POPULATE_WRITE not supported, prefaulting disabled");
+			prefault_unsupported = 1;
+			queue_len = 0;
+		} else if (ret) {
+			GP_WARN("madvise(MADV_POPULATE_WRITE) failed: %s", strerror(errno));
+			queue_cancel(busy_addr);
+		}
+
+		busy_addr = NULL;
+		pthread_cond_broadcast(&done);
+	}
+
+	return NULL;
+}
+
+void neko_prefault_init(int enabled)
+{
+	pthread_t thread;
+
+	if (!enabled)
+		return;
+
+	if (pthread_create(&thread, NULL, prefault_thread, NULL)) {
+		GP_WARN("Failed to create prefault thread");
+		return;
+	}
+
+	pthread_detach(thread);
+
+	GP_DEBUG(1, "SHM prefaulting enabled");
+
+	prefault_enabled = 1;
+}
+
+void neko_prefault(void *addr, size_t size)
+{
+	if (!prefault_enabled)
+		return;
+
+	pthread_mutex_lock(&lock);
+
+	if (prefault_unsupported)
+		goto ret;
+
+	if (queue_len >= PREFAULT_QUEUE) {
+		GP_DEBUG(1, "Prefault queue full");
+		goto ret;
+	}
+
+	queue[queue_len++] = (struct prefault_req) {
+		.addr = addr,
+		.size = size,
+	};
+
+	pthread_cond_signal(&queued);
+ret:
+	pthread_mutex_unlock(&lock);
+}
+
+void neko_prefault_cancel(void *addr)
+{
+	if (!prefault_enabled)
+		return;
+
+	pthread_mutex_lock(&lock);
+
+	queue_cancel(addr);
+
+	while (busy_addr == addr)
+		pthread_cond_wait(&done, &lock);
+
+	pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,51 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief Asynchronous SHM prefaulting.
+ * @file neko_prefault.h
+ *
+ * Freshly created SHM is not backed by any memory and the first frame blitted
+ * from it page faults through the whole buffer. The prefault thread populates
+ * the SHM pages in the background so that the main loop does not stall on
+ * the faults. The pages are shared with the app, so the app does not have to
+ * allocate and clear them either.
+ */
+
+#ifndef NEKO_PREFAULT_H
+#define NEKO_PREFAULT_H
+
+#include <stddef.h>
+
+/**
+ * @brief Starts the prefault thread.
+ *
+ * @param enabled If zero prefaulting is disabled.
+ */
+void neko_prefault_init(int enabled);
+
+/**
+ * @brief Queues a mapping to be populated.
+ *
+ * Does nothing if prefaulting is disabled or the queue is full.
+ *
+ * @param addr A start of the mapping.
+ * @param size A size of the mapping.
+ */
+void neko_prefault(void *addr, size_t size);
+
+/**
+ * @brief Cancels populating of a mapping.
+ *
+ * Has to be called before the mapping is unmapped or remapped. Waits for the
+ * prefault thread to finish the chunk it may be working on.
+ *
+ * @param addr A start of the mapping.
+ */
+void neko_prefault_cancel(void *addr);
+
+#endif /* NEKO_PREFAULT_H */
@@ -0,0 +1,187 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <core/gp_common.h>
+
+#include "neko_region.h"
+
+int neko_rect_intersect(neko_rect *res, const neko_rect *a, const neko_rect *b)
+{
+	int64_t x0 = GP_MAX(a->x, b->x);
+	int64_t y0 = GP_MAX(a->y, b->y);
+	int64_t x1 = GP_MIN((int64_t)a->x + a->w, (int64_t)b->x + b->w);
+	int64_t y1 = GP_MIN((int64_t)a->y + a->h, (int64_t)b->y + b->h);
+
+	if (x1 <= x0 || y1 <= y0) {
+		res->w = 0;
+		res->h = 0;
+		return 0;
+	}
+
+	res->x = x0;
+	res->y = y0;
+	res->w = x1 - x0;
+	res->h = y1 - y0;
+
+	return 1;
+}
+
+void neko_rect_union(neko_rect *res, const neko_rect *a, const neko_rect *b)
+{
+	int64_t x0 = GP_MIN(a->x, b->x);
+	int64_t y0 = GP_MIN(a->y, b->y);
+	int64_t x1 = GP_MAX((int64_t)a->x + a->w, (int64_t)b->x + b->w);
+	int64_t y1 = GP_MAX((int64_t)a->y + a->h, (int64_t)b->y + b->h);
+
+	res->x = x0;
+	res->y = y0;
+	res->w = x1 - x0;
+	res->h = y1 - y0;
+}
+
+static int rect_contains(const neko_rect *a, const neko_rect *b)
+{
+	return b->x >= a->x && b->y >= a->y &&
+	       (int64_t)b->x + b->w <= (int64_t)a->x + a->w &&
+	       (int64_t)b->y + b->h <= (int64_t)a->y + a->h;
+}
+
+/*
+ * Returns true if merging the rectangles does not add any area, i.e. they
+ * overlap or share a whole edge.
+ */
+static int rect_mergeable(const neko_rect *a, const neko_rect *b)
+{
+	neko_rect tmp;
+
+	if (neko_rect_intersect(&tmp, a, b))
+		return 1;
+
+	if (a->x == b->x && a->w == b->w &&
+	    ((int64_t)a->y + a->h == b->y || (int64_t)b->y + b->h == a->y))
+		return 1;
+
+	if (a->y == b->y && a->h == b->h &&
+	    ((int64_t)a->x + a->w == b->x || (int64_t)b->x + b->w == a->x))
+		return 1;
+
+	return 0;
+}
+
+static void region_rem(neko_region *self, unsigned int i)
+{
+	self->rects[i] = self->rects[--self->cnt];
+}
+
+static unsigned int region_cheapest_merge(neko_region *self, const neko_rect *rect)
+{
+	unsigned int i, best = 0;
+	uint64_t best_cost = UINT64_MAX;
+
+	for (i = 0; i < self->cnt; i++) {
+		neko_rect tmp;
+
+		neko_rect_union(&tmp, &self->rects[i], rect);
+
+		uint64_t cost = neko_rect_area(&tmp) - neko_rect_area(&self->rects[i]);
+
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+void neko_region_add(neko_region *self, const neko_rect *rect)
+{
+	neko_rect r = *rect;
+	unsigned int i;
+
+	if (!r.w || !r.h)
+		return;
+
+again:
+	for (i = 0; i < self->cnt; i++) {
+		if (rect_contains(&self->rects[i], &r))
+			return;
+
+		if (rect_mergeable(&self->rects[i], &r)) {
+			neko_rect_union(&r, &r, &self->rects[i]);
+			region_rem(self, i);
+			goto again;
+		}
+	}
+
+	if (self->cnt < NEKO_REGION_RECTS) {
+		self->rects[self->cnt++] = r;
+		return;
+	}
+
+	i = region_cheapest_merge(self, &r);
+	neko_rect_union(&r, &r, &self->rects[i]);
+	region_rem(self, i);
+	goto again;
+}
+
+/*
+ * Returns how much cheaper it is to flush the bounding box of the two
+ * rectangles instead of each of them, negative if it's more expensive.
+ */
+static int64_t merge_gain(const neko_rect *a, const neko_rect *b, uint64_t setup)
+{
+	neko_rect u;
+
+	neko_rect_union(&u, a, b);
+
+	return (int64_t)(setup + neko_rect_area(a) + neko_rect_area(b)) -
+	       (int64_t)neko_rect_area(&u);
+}
+
+void neko_region_merge(neko_region *self, uint64_t setup)
+{
+	unsigned int i, j, best_i = 0, best_j = 0;
+
+	if (!setup)
+		return;
+
+	for (;;) {
+		int64_t best_gain = 0;
+
+		for (i = 0; i < self->cnt; i++) {
+			for (j = i + 1; j < self->cnt; j++) {
+				int64_t gain = merge_gain(&self->rects[i], &self->rects[j], setup);
+
+				if (gain > best_gain) {
+					best_gain = gain;
+					best_i = i;
+					best_j = j;
+				}
+			}
+		}
+
+		if (!best_gain)
+			return;
+
+		neko_region tmp = *self;
+		neko_rect u;
+
+		neko_rect_union(&u, &tmp.rects[best_i], &tmp.rects[best_j]);
+
+		/* best_j > best_i so removing it first does not move best_i */
+		region_rem(&tmp, best_j);
+		region_rem(&tmp, best_i);
+
+		/* Adding the rects again merges these overlapped by the union */
+		neko_region_clear(self);
+		neko_region_add(self, &u);
+
+		for (i = 0; i < tmp.cnt; i++)
+			neko_region_add(self, &tmp.rects[i]);
+	}
+}
@@ -0,0 +1,126 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A set of rectangles.
+ * @file neko_region.h
+ *
+ * Region is a small fixed size set of non-overlapping rectangles used to
+ * accumulate the parts of the screen that has to be updated.
+ */
+
+#ifndef NEKO_REGION_H
+#define NEKO_REGION_H
+
+#include <stdint.h>
+#include <core/gp_types.h>
+
+/** @brief Maximal number of rectangles in a region. */
+#define NEKO_REGION_RECTS 16
+
+/**
+ * @brief A rectangle.
+ */
+typedef struct neko_rect {
+	/** @brief A x offset. */
+	gp_coord x;
+	/** @brief A y offset. */
+	gp_coord y;
+	/** @brief A width. */
+	gp_size w;
+	/** @brief A height. */
+	gp_size h;
+} neko_rect;
+
+/**
+ * @brief A region.
+ *
+ * Once the region is full adding a rectangle merges it with the existing
+ * rectangle whose bounding box grows the least.
+ */
+typedef struct neko_region {
+	/** @brief Number of rectangles in the region. */
+	unsigned int cnt;
+	/** @brief Rectangles, these do not overlap. */
+	neko_rect rects[NEKO_REGION_RECTS];
+} neko_region;
+
+/**
+ * @brief Returns a rectangle area.
+ *
+ * @param rect A rectangle.
+ * @return A rectangle area in pixels.
+ */
+static inline uint64_t neko_rect_area(const neko_rect *rect)
+{
+	return (uint64_t)rect->w * rect->h;
+}
+
+/**
+ * @brief Intersects two rectangles.
+ *
+ * @param res A rectangle to store the result to, may be one of the a or b.
+ * @param a A rectangle.
+ * @param b A rectangle.
+ * @return Non-zero if the intersection is not empty.
+ */
+int neko_rect_intersect(neko_rect *res, const neko_rect *a, const neko_rect *b);
+
+/**
+ * @brief Computes a bounding box of two rectangles.
+ *
+ * @param res A rectangle to store the result to, may be one of the a or b.
+ * @param a A rectangle.
+ * @param b A rectangle.
+ */
+void neko_rect_union(neko_rect *res, const neko_rect *a, const neko_rect *b);
+
+/**
+ * @brief Adds a rectangle into a region.
+ *
+ * Rectangles that overlap or share a whole edge with the newly added one are
+ * merged into it.
+ *
+ * @param self A region.
+ * @param rect A rectangle to add.
+ */
+void neko_region_add(neko_region *self, const neko_rect *rect);
+
+/**
+ * @brief Merges rectangles whose bounding box is cheaper to flush.
+ *
+ * The cost of flushing a rectangle is modeled as a constant per rectangle
+ * setup cost plus the rectangle area. Pairs of rectangles are merged into
+ * their bounding box for as long as it lowers the overall cost.
+ *
+ * @param self A region.
+ * @param setup A per rectangle setup cost in pixels, zero disables merging.
+ */
+void neko_region_merge(neko_region *self, uint64_t setup);
+
+/**
+ * @brief Removes all rectangles from a region.
+ *
+ * @param self A region.
+ */
+static inline void neko_region_clear(neko_region *self)
+{
+	self->cnt = 0;
+}
+
+/**
+ * @brief Returns true if region is empty.
+ *
+ * @param self A region.
+ * @return Non-zero if there are no rectangles in the region.
+ */
+static inline int neko_region_is_empty(const neko_region *self)
+{
+	return !self->cnt;
+}
+
+#endif /* NEKO_REGION_H */
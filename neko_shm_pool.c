@@ -0,0 +1,86 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <core/gp_debug.h>
+
+#include "neko_prefault.h"
+#include "neko_shm_pool.h"
+
+static gp_dlist pool;
+static size_t pool_apps;
+static size_t pool_mem;
+static size_t pool_max_apps;
+static size_t pool_max_mem;
+
+static size_t shm_size(gp_proxy_shm *shm)
+{
+	return shm->size;
+}
+
+void neko_shm_pool_init(size_t max_apps, size_t max_mem)
+{
+	GP_DEBUG(1, "SHM pool max apps %zu max mem %zukB", max_apps, max_mem/1024);
+
+	pool_max_apps = max_apps;
+	pool_max_mem = max_mem;
+}
+
+static void pool_rem(neko_shm_pool_entry *entry)
+{
+	if (!entry->pooled)
+		return;
+
+	gp_dlist_rem(&pool, &entry->list);
+
+	pool_apps--;
+	pool_mem -= shm_size(*entry->shm);
+
+	entry->pooled = 0;
+}
+
+void neko_shm_pool_evict(neko_shm_pool_entry *entry)
+{
+	pool_rem(entry);
+
+	if (!*entry->shm)
+		return;
+
+	GP_DEBUG(2, "Evicting SHM %p", *entry->shm);
+
+	neko_prefault_cancel((*entry->shm)->base);
+	gp_proxy_shm_exit(*entry->shm);
+	*entry->shm = NULL;
+}
+
+void neko_shm_pool_put(neko_shm_pool_entry *entry)
+{
+	if (!*entry->shm)
+		return;
+
+	/* Move to the head if already pooled */
+	pool_rem(entry);
+
+	gp_dlist_push_head(&pool, &entry->list);
+	entry->pooled = 1;
+
+	pool_apps++;
+	pool_mem += shm_size(*entry->shm);
+
+	while (pool_apps > pool_max_apps || pool_mem > pool_max_mem) {
+		neko_shm_pool_entry *lru = GP_LIST_ENTRY(pool.tail, neko_shm_pool_entry, list);
+
+		if (lru->on_evict)
+			lru->on_evict(lru);
+
+		neko_shm_pool_evict(lru);
+	}
+}
+
+void neko_shm_pool_get(neko_shm_pool_entry *entry)
+{
+	pool_rem(entry);
+}
@@ -0,0 +1,77 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief A pool of SHM buffers of hidden apps.
+ * @file neko_shm_pool.h
+ *
+ * The SHM buffers of apps that were hidden are kept mapped so that the app
+ * can be shown again without creating a new SHM and the last frame can be
+ * painted on the screen right away. The pool is limited by number of apps and
+ * by memory, the least recently hidden apps are evicted first.
+ */
+
+#ifndef NEKO_SHM_POOL_H
+#define NEKO_SHM_POOL_H
+
+#include <stddef.h>
+#include <utils/gp_list.h>
+#include <backends/gp_proxy_shm.h>
+
+/**
+ * @brief A pool entry, embedded in the app.
+ */
+typedef struct neko_shm_pool_entry {
+	/** @brief A pointer to the app SHM, set to NULL on eviction. */
+	gp_proxy_shm **shm;
+	/** @brief A pool list head. */
+	gp_dlist_head list;
+	/** @brief Set if the entry is in the pool. */
+	int pooled;
+	/**
+	 * @brief Called before the SHM is freed because the pool is full.
+	 *
+	 * May be NULL.
+	 */
+	void (*on_evict)(struct neko_shm_pool_entry *self);
+	/** @brief A user pointer. */
+	void *priv;
+} neko_shm_pool_entry;
+
+/**
+ * @brief Sets the pool limits.
+ *
+ * @param max_apps Maximal number of hidden apps to keep the SHM for.
+ * @param max_mem Maximal size of all the SHM buffers in the pool in bytes.
+ */
+void neko_shm_pool_init(size_t max_apps, size_t max_mem);
+
+/**
+ * @brief Puts an SHM of a hidden app into the pool.
+ *
+ * May evict the least recently hidden apps, including this one if the SHM
+ * does not fit into the pool at all.
+ *
+ * @param entry A pool entry.
+ */
+void neko_shm_pool_put(neko_shm_pool_entry *entry);
+
+/**
+ * @brief Takes an SHM out of the pool when app is shown again.
+ *
+ * @param entry A pool entry.
+ */
+void neko_shm_pool_get(neko_shm_pool_entry *entry);
+
+/**
+ * @brief Removes the entry from the pool and frees the SHM.
+ *
+ * @param entry A pool entry.
+ */
+void neko_shm_pool_evict(neko_shm_pool_entry *entry);
+
+#endif /* NEKO_SHM_POOL_H */
@@ -0,0 +1,245 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <core/gp_core.h>
+#include <utils/gp_list.h>
+
+#include "neko_snapshot.h"
+
+struct neko_snapshot {
+	/* Pointer to the snapshot owner, set to NULL when freed */
+	neko_snapshot **owner;
+	gp_dlist_head list;
+
+	gp_size w;
+	gp_size h;
+	uint32_t bytes_per_row;
+	gp_pixel_type pixel_type;
+
+	/* Size of the uncompressed data */
+	size_t size;
+	/* Size of the data array */
+	size_t data_size;
+	int rle;
+	uint8_t data[];
+};
+
+static gp_dlist snapshots;
+static size_t snapshots_mem;
+static size_t snapshots_max_mem;
+static int snapshots_rle;
+
+void neko_snapshot_init(size_t max_mem, int rle)
+{
+	GP_DEBUG(1, "Snapshots max mem %zukB rle %i", max_mem/1024, rle);
+
+	snapshots_max_mem = max_mem;
+	snapshots_rle = rle;
+}
+
+/*
+ * PackBits like RLE on pixels, packed pixels are compressed by bytes.
+ *
+ * The control byte c is followed by c+1 literal pixels for c < 128 and by a
+ * single pixel repeated c-126 times otherwise. Runs shorter than three pixels
+ * are stored as literals so that the output never grows more than by one byte
+ * per RLE_MAX_LIT pixels.
+ */
+#define RLE_MAX_LIT 128
+#define RLE_MAX_RUN 129
+#define RLE_MIN_RUN 3
+
+static size_t rle_bound(size_t size)
+{
+	return size + size/RLE_MAX_LIT + 1;
+}
+
+static size_t rle_run(const uint8_t *src, size_t pos, size_t len, size_t bpp)
+{
+	size_t run = 1;
+
+	while (pos + (run + 1) * bpp <= len && run < RLE_MAX_RUN &&
+	       !memcmp(src + pos, src + pos + run * bpp, bpp))
+		run++;
+
+	return run;
+}
+
+static size_t rle_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t bpp)
+{
+	size_t pos = 0, out = 0;
+
+	while (pos < len) {
+		size_t run = rle_run(src, pos, len, bpp);
+
+		if (run >= RLE_MIN_RUN) {
+			dst[out++] = run + 126;
+			memcpy(dst + out, src + pos, bpp);
+			out += bpp;
+			pos += run * bpp;
+			continue;
+		}
+
+		size_t lit = 0;
+		size_t ctrl = out++;
+
+		while (pos < len && lit < RLE_MAX_LIT &&
+		       (lit == 0 || rle_run(src, pos, len, bpp) < RLE_MIN_RUN)) {
+			memcpy(dst + out, src + pos, bpp);
+			out += bpp;
+			pos += bpp;
+			lit++;
+		}
+
+		dst[ctrl] = lit - 1;
+	}
+
+	return out;
+}
+
+static int rle_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t size, size_t bpp)
+{
+	size_t pos = 0, out = 0;
+
+	while (pos < len) {
+		size_t c = src[pos++];
+
+		if (c < RLE_MAX_LIT) {
+			size_t bytes = (c + 1) * bpp;
+
+			if (out + bytes > size || pos + bytes > len)
+				return 1;
+
+			memcpy(dst + out, src + pos, bytes);
+			out += bytes;
+			pos += bytes;
+			continue;
+		}
+
+		size_t run = c - 126;
+
+		if (out + run * bpp > size || pos + bpp > len)
+			return 1;
+
+		while (run--) {
+			memcpy(dst + out, src + pos, bpp);
+			out += bpp;
+		}
+
+		pos += bpp;
+	}
+
+	return out != size;
+}
+
+static size_t rle_unit(gp_pixel_type pixel_type, size_t size)
+{
+	size_t bpp = gp_pixel_size(pixel_type);
+
+	/* Packed pixels or rows padded to a size not divisible by pixel size */
+	if (bpp < 8 || size % (bpp/8))
+		return 1;
+
+	return bpp/8;
+}
+
+void neko_snapshot_free(neko_snapshot **owner)
+{
+	neko_snapshot *self = *owner;
+
+	if (!self)
+		return;
+
+	gp_dlist_rem(&snapshots, &self->list);
+	snapshots_mem -= self->data_size;
+
+	*owner = NULL;
+	free(self);
+}
+
+static void snapshot_fit(size_t size)
+{
+	while (snapshots.tail && snapshots_mem + size > snapshots_max_mem) {
+		neko_snapshot *oldest = GP_LIST_ENTRY(snapshots.tail, neko_snapshot, list);
+
+		GP_DEBUG(2, "Freeing snapshot %p", oldest);
+
+		neko_snapshot_free(oldest->owner);
+	}
+}
+
+void neko_snapshot_take(neko_snapshot **owner, const gp_pixmap *pixmap)
+{
+	size_t size = (size_t)pixmap->bytes_per_row * pixmap->h;
+	size_t data_size = snapshots_rle ? rle_bound(size) : size;
+	neko_snapshot *self;
+
+	neko_snapshot_free(owner);
+
+	if (size > snapshots_max_mem)
+		return;
+
+	self = malloc(sizeof(*self) + data_size);
+	if (!self) {
+		GP_WARN("Failed to allocate snapshot");
+		return;
+	}
+
+	self->w = pixmap->w;
+	self->h = pixmap->h;
+	self->bytes_per_row = pixmap->bytes_per_row;
+	self->pixel_type = pixmap->pixel_type;
+	self->size = size;
+	self->rle = snapshots_rle;
+
+	if (self->rle) {
+		data_size = rle_compress(pixmap->pixels, size, self->data,
+		                         rle_unit(pixmap->pixel_type, size));
+
+		neko_snapshot *tmp = realloc(self, sizeof(*self) + data_size);
+		if (tmp)
+			self = tmp;
+
+		GP_DEBUG(2, "Snapshot compressed %zu -> %zu", size, data_size);
+	} else {
+		memcpy(self->data, pixmap->pixels, size);
+	}
+
+	self->data_size = data_size;
+
+	snapshot_fit(data_size);
+
+	if (snapshots_mem + data_size > snapshots_max_mem) {
+		free(self);
+		return;
+	}
+
+	self->owner = owner;
+	*owner = self;
+
+	gp_dlist_push_head(&snapshots, &self->list);
+	snapshots_mem += data_size;
+}
+
+int neko_snapshot_restore(neko_snapshot *self, gp_pixmap *pixmap)
+{
+	if (self->w != pixmap->w || self->h != pixmap->h ||
+	    self->bytes_per_row != pixmap->bytes_per_row ||
+	    self->pixel_type != pixmap->pixel_type)
+		return 1;
+
+	if (!self->rle) {
+		memcpy(pixmap->pixels, self->data, self->size);
+		return 0;
+	}
+
+	return rle_decompress(self->data, self->data_size, pixmap->pixels,
+	                      self->size, rle_unit(self->pixel_type, self->size));
+}
@@ -0,0 +1,64 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/**
+ * @brief Last frame snapshots of hidden apps.
+ * @file neko_snapshot.h
+ *
+ * When an app SHM is evicted from the SHM pool the last frame is copied into
+ * a snapshot, optionally RLE compressed, so that it can be painted right away
+ * when the app is shown again. Snapshots are limited by memory, the oldest
+ * snapshots are freed first.
+ */
+
+#ifndef NEKO_SNAPSHOT_H
+#define NEKO_SNAPSHOT_H
+
+#include <stddef.h>
+#include <core/gp_types.h>
+
+typedef struct neko_snapshot neko_snapshot;
+
+/**
+ * @brief Sets the snapshot limits.
+ *
+ * @param max_mem Maximal size of all snapshots in bytes, zero disables
+ *                snapshots.
+ * @param rle If set the snapshots are RLE compressed.
+ */
+void neko_snapshot_init(size_t max_mem, int rle);
+
+/**
+ * @brief Takes a snapshot of a pixmap.
+ *
+ * Frees the previous snapshot stored in owner, if any. May free the oldest
+ * snapshots to fit the memory limit, in that case the pointer to the snapshot
+ * is set to NULL.
+ *
+ * @param owner A pointer to store the snapshot to.
+ * @param pixmap A pixmap to take the snapshot of.
+ */
+void neko_snapshot_take(neko_snapshot **owner, const gp_pixmap *pixmap);
+
+/**
+ * @brief Restores a snapshot into a pixmap.
+ *
+ * @param self A snapshot.
+ * @param pixmap A pixmap to restore the snapshot into.
+ * @return Zero on success, non-zero if the pixmap size or pixel type does not
+ *         match the snapshot.
+ */
+int neko_snapshot_restore(neko_snapshot *self, gp_pixmap *pixmap);
+
+/**
+ * @brief Frees a snapshot.
+ *
+ * @param owner A pointer to the snapshot, set to NULL.
+ */
+void neko_snapshot_free(neko_snapshot **owner);
+
+#endif /* NEKO_SNAPSHOT_H */
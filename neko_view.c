@@ -11,27 +11,34 @@
 
 #include "neko_keybindings.h"
 #include "neko_ctx.h"
+#include "neko_damage.h"
 #include "neko_view.h"
 
 void neko_view_update_rect(neko_view *self, gp_coord x, gp_coord y, gp_size w, gp_size h)
 {
-	if (x + w > self->w) {
-		GP_WARN("x = %u + w = %u > self->w %u", x, w, self->w);
-		w = self->w - x;
+	neko_rect view = {self->x, self->y, self->w, self->h};
+	neko_rect rect = {self->x + x, self->y + y, w, h};
+	neko_rect clipped;
+
+	if (!neko_rect_intersect(&clipped, &rect, &view)) {
+		GP_WARN("Rect %ix%i-%ux%u outside of view %ux%u",
+		        x, y, w, h, self->w, self->h);
+		return;
 	}
 
-	if (y + h > self->h) {
-		GP_WARN("y = %u + h = %u > self->h %u",
-                        y, h, self->h);
-		h = self->y - y;
+	if (clipped.w != w || clipped.h != h) {
+		GP_WARN("Rect %ix%i-%ux%u clipped to view %ux%u",
+		        x, y, w, h, self->w, self->h);
 	}
 
-	gp_backend_update_rect_xywh(ctx.backend, self->x + x, self->y + y, w, h);
+	neko_damage_add(&clipped);
 }
 
 void neko_view_flip(neko_view *self)
 {
-	gp_backend_update_rect_xywh(ctx.backend, self->x, self->y, self->w, self->h);
+	neko_rect view = {self->x, self->y, self->w, self->h};
+
+	neko_damage_add(&view);
 }
 
 static void empty_view(neko_view *self)
@@ -117,6 +124,34 @@ void neko_view_repaint(neko_view *self)
 		empty_view(self);
 }
 
+/*
+ * The leaf view the input from focused_root is routed to, NULL if it has to
+ * be looked up again. Cleared whenever the focus or the view tree changes.
+ */
+static neko_view *focused_root;
+static neko_view *focused_leaf;
+
+static void focused_leaf_invalidate(void)
+{
+	focused_leaf = NULL;
+}
+
+static neko_view *focused_leaf_lookup(neko_view *root)
+{
+	neko_view *view = root;
+
+	if (focused_leaf && focused_root == root)
+		return focused_leaf;
+
+	while (!view->slot && neko_view_focused_child(view))
+		view = neko_view_focused_child(view);
+
+	focused_root = root;
+	focused_leaf = view;
+
+	return view;
+}
+
 void neko_view_init(neko_view *self,
                     gp_size x, gp_size y, gp_size w, gp_size h,
 		    const char *name)
@@ -149,6 +184,8 @@ void neko_subviews_init(neko_view *left, neko_view *right, neko_view *parent, en
 
 	parent->split_mode = mode;
 
+	focused_leaf_invalidate();
+
 	switch (mode) {
 	case NEKO_VIEW_SPLIT_HORIZ:
 		split_horiz(parent);
@@ -188,6 +225,8 @@ void neko_view_slot_rem(neko_view *self)
 		self->slot->view = NULL;
 
 	self->slot = NULL;
+
+	focused_leaf_invalidate();
 }
 
 void neko_view_slot_put(neko_view *self, neko_view_slot *slot)
@@ -197,6 +236,8 @@ void neko_view_slot_put(neko_view *self, neko_view_slot *slot)
 
 	self->slot = slot;
 
+	focused_leaf_invalidate();
+
 	if (slot) {
 		neko_view *view = slot->view;
 		neko_view_slot_rem(view);
@@ -232,6 +273,7 @@ static int try_switch_focus(neko_view *view)
 	if (view->subviews[0] && view->subviews[1]) {
 		neko_view_focus_out(view->subviews[view->focused_subview]);
 		view->focused_subview = !view->focused_subview;
+		focused_leaf_invalidate();
 		neko_view_focus_in(view->subviews[view->focused_subview]);
 		neko_view_repaint(view);
 		return 1;
@@ -297,6 +339,20 @@ void neko_view_hide(neko_view *self)
 
 void neko_view_event(neko_view *self, gp_event *ev)
 {
+	/*
+	 * Only WM key combinations and pointer motion are handled on the way
+	 * down, everything else goes directly to the focused leaf.
+	 */
+	if (!(ev->type == GP_EV_KEY && gp_ev_any_key_pressed(ev, NEKO_KEYS_MOD_WM)) &&
+	    !(ev->type == GP_EV_REL && ev->code == GP_EV_REL_POS)) {
+		neko_view *leaf = focused_leaf_lookup(self);
+
+		if (leaf->slot)
+			leaf->slot->ops->event(leaf, ev);
+
+		return;
+	}
+
 	switch (ev->type) {
 	case GP_EV_KEY:
 		if (!gp_ev_any_key_pressed(ev, NEKO_KEYS_MOD_WM))
@@ -315,6 +371,7 @@ void neko_view_event(neko_view *self, gp_event *ev)
 			if (cursor_in_view(self->subviews[0], ev) && self->focused_subview == 1) {
 				neko_view_focus_out(self->subviews[self->focused_subview]);
 				self->focused_subview = 0;
+				focused_leaf_invalidate();
 				neko_view_focus_in(self->subviews[self->focused_subview]);
 				neko_view_repaint(self);
 			}
@@ -322,6 +379,7 @@ void neko_view_event(neko_view *self, gp_event *ev)
 			if (cursor_in_view(self->subviews[1], ev) && self->focused_subview == 0) {
 				neko_view_focus_out(self->subviews[self->focused_subview]);
 				self->focused_subview = 1;
+				focused_leaf_invalidate();
 				neko_view_focus_in(self->subviews[self->focused_subview]);
 				neko_view_repaint(self);
 			}
@@ -216,9 +216,15 @@ static inline void neko_view_slot_exit(neko_view *self)
  * @brief Update rectangle in the view on the screen.
  *
  * This is called by the child when content needs to be updated from the view
- * pixmap and painted on the screen.
+ * pixmap and painted on the screen. The rectangle is clipped to the view and
+ * added to the screen damage that is flushed at the end of the main loop
+ * iteration.
  *
  * @param self A neko view.
+ * @param x A x offset in the view.
+ * @param y A y offset in the view.
+ * @param w A rectangle width.
+ * @param h A rectangle height.
  */
 void neko_view_update_rect(neko_view *self, gp_coord x, gp_coord y, gp_size w, gp_size h);
 
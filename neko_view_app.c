@@ -5,12 +5,25 @@
 
  */
 
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/sockios.h>
 #include <gfxprim.h>
 
 #include <backends/gp_proxy_shm.h>
 #include <backends/gp_proxy_cli.h>
 
 #include "neko_keybindings.h"
+#include "neko_blit.h"
+#include "neko_frame.h"
+#include "neko_prefault.h"
+#include "neko_shm_pool.h"
+#include "neko_snapshot.h"
 #include "neko_view.h"
 #include "neko_ctx.h"
 #include "neko_view_running_apps.h"
@@ -22,8 +35,53 @@ extern gp_dlist apps_list;
 struct app {
 	gp_proxy_cli *cli;
 	gp_proxy_shm *shm;
+	/* Keeps the SHM mapped while the app is hidden */
+	neko_shm_pool_entry pool;
+	/* Last frame of a hidden app whose SHM has been evicted from the pool */
+	neko_snapshot *snapshot;
+	/* A gp_vec of updated rects waiting to be blitted to the screen */
+	struct gp_proxy_rect *updates;
+	/* A gp_vec of updated rects waiting to be presented on the screen */
+	struct gp_proxy_rect *acks;
+	/* The app socket send buffer size */
+	int sndbuf;
+	/* When the app socket buffer got filled over the watermark, in ms */
+	uint64_t congested_since;
+	/* Set if the app does not read its socket for a long time */
+	unsigned int unresponsive:1;
+	/* Set if the app gets all motion events */
+	unsigned int motion_raw:1;
+	/* Set if there is a coalesced motion event to be sent */
+	unsigned int motion_pending:1;
+	/* Motion events coalesced during the main loop iteration */
+	gp_event motion;
 };
 
+/* Motion is dropped when the app socket buffer is filled over the percentage */
+#define APP_CONGESTED_PCT 50
+/* App that does not read events for that long in ms is marked unresponsive */
+#define APP_UNRESPONSIVE_MS 3000
+/* The kernel accounts some bookkeeping for each message queued in a socket */
+#define APP_MSG_OVERHEAD 1024
+
+/* Number of updated rects in all apps waiting to be blitted */
+static size_t updates_pending;
+
+/* Number of updated rects in all apps waiting to be acked */
+static size_t acks_pending;
+
+static enum neko_view_app_ack ack_mode = NEKO_VIEW_APP_ACK_PRESENT;
+
+/* The name is not known until the app sends the GP_PROXY_NAME message */
+static const char *app_name(struct app *app)
+{
+	return app->cli->name ? app->cli->name : "?";
+}
+
+static int motion_coalesce = 1;
+/* Comma separated names of apps that get all motion events */
+static char motion_raw_apps[128];
+
 /* A gp_vec of all connected apps. */
 neko_view_slot **neko_apps;
 
@@ -31,6 +89,13 @@ neko_view_slot **neko_apps;
 
 static const neko_view_slot_ops app_ops;
 
+static void app_shm_evict(neko_shm_pool_entry *entry)
+{
+	struct app *app = entry->priv;
+
+	neko_snapshot_take(&app->snapshot, &app->shm->pixmap);
+}
+
 /**
  * @brief Called when new application has connected.
  *
@@ -53,6 +118,97 @@ static void neko_cli_disconnected(void)
 	neko_view_exit_app_disconnected();
 }
 
+/*
+ * A write to an app that does not read its socket blocks once the socket
+ * buffer is full, we make sure that it does not block the whole nekowm by
+ * checking that there is enough space for a message before it's sent.
+ */
+static void app_socket_setup(struct app *app)
+{
+	int fd = app->cli->fd.fd;
+	socklen_t len = sizeof(app->sndbuf);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &app->sndbuf, &len)) {
+		GP_WARN("Failed to get send buffer size: %s", strerror(errno));
+		app->sndbuf = 0;
+	}
+}
+
+/* Returns number of bytes queued in the app socket or -1 if unknown */
+static int app_queued(struct app *app)
+{
+	int queued;
+
+	if (!app->sndbuf)
+		return -1;
+
+	if (ioctl(app->cli->fd.fd, SIOCOUTQ, &queued))
+		return -1;
+
+	return queued;
+}
+
+static int app_congested(struct app *app, int queued)
+{
+	if (queued < 0)
+		return 0;
+
+	return (int64_t)queued * 100 > (int64_t)app->sndbuf * APP_CONGESTED_PCT;
+}
+
+/*
+ * Returns non-zero if a message of the size fits into the app socket buffer,
+ * a message is never split, it's either sent whole or not at all.
+ */
+static int app_has_room(struct app *app, int queued, size_t size)
+{
+	if (queued < 0)
+		return 1;
+
+	return (int64_t)app->sndbuf - queued >= (int64_t)(size + APP_MSG_OVERHEAD);
+}
+
+/*
+ * Updates the app responsiveness from the number of bytes queued in the app
+ * socket, returns non-zero if the socket is congested.
+ */
+static int app_check_congestion(struct app *app, int queued)
+{
+	uint64_t now;
+
+	if (!app_congested(app, queued)) {
+		app->congested_since = 0;
+
+		if (app->unresponsive) {
+			GP_DEBUG(1, "App '%s' is responding again", app_name(app));
+			app->unresponsive = 0;
+			neko_running_apps_changed();
+		}
+
+		return 0;
+	}
+
+	now = neko_frame_time();
+
+	if (!app->congested_since)
+		app->congested_since = now;
+
+	if (!app->unresponsive && now - app->congested_since > APP_UNRESPONSIVE_MS) {
+		GP_WARN("App '%s' is not responding", app_name(app));
+		app->unresponsive = 1;
+		neko_running_apps_changed();
+	}
+
+	return 1;
+}
+
+int neko_view_app_responding(neko_view_slot *self)
+{
+	struct app *app = APP_PRIV(self);
+
+	return !app->unresponsive;
+}
+
 neko_view_slot *neko_view_app_init(gp_proxy_cli *cli)
 {
 	neko_view_slot *ret = malloc(sizeof(neko_view_slot) + sizeof(struct app));
@@ -67,17 +223,40 @@ neko_view_slot *neko_view_app_init(gp_proxy_cli *cli)
 
 	app->cli = cli;
 	app->shm = NULL;
+	app->pool.shm = &app->shm;
+	app->pool.pooled = 0;
+	app->pool.on_evict = app_shm_evict;
+	app->pool.priv = app;
+	app->snapshot = NULL;
+	app->congested_since = 0;
+	app->unresponsive = 0;
+	app->motion_raw = 0;
+	app->motion_pending = 0;
+
+	app_socket_setup(app);
+
+	app->updates = gp_vec_new(0, sizeof(struct gp_proxy_rect));
+	if (!app->updates)
+		goto err1;
+
+	app->acks = gp_vec_new(0, sizeof(struct gp_proxy_rect));
+	if (!app->acks)
+		goto err2;
 
 	if (!neko_apps) {
 		neko_apps = gp_vec_new(0, sizeof(neko_view_slot *));
 		if (!neko_apps)
-			goto err1;
+			goto err3;
 	}
 
 	if (!GP_VEC_APPEND(neko_apps, ret))
-		goto err1;
+		goto err3;
 
 	return ret;
+err3:
+	gp_vec_free(app->acks);
+err2:
+	gp_vec_free(app->updates);
 err1:
 	free(ret);
 err0:
@@ -91,13 +270,148 @@ gp_proxy_cli *neko_view_app_cli(neko_view_slot *self)
 	return app->cli;
 }
 
+/*
+ * The SHM may be larger than the view, the pixmap only describes the part
+ * used by the view.
+ */
+static size_t shm_bytes(gp_size w, gp_size h, gp_pixel_type pixel_type)
+{
+	return ((size_t)w * gp_pixel_size(pixel_type) + 7) / 8 * h;
+}
+
+static int app_shm_fits(struct app *app, gp_size w, gp_size h)
+{
+	return shm_bytes(w, h, app->shm->pixmap.pixel_type) <= app->shm->size;
+}
+
+static void app_shm_map(struct app *app, gp_size w, gp_size h)
+{
+	gp_proxy_shm *shm = app->shm;
+
+	gp_pixmap_init(&shm->pixmap, w, h, shm->pixmap.pixel_type, shm->base, 0);
+}
+
+/*
+ * SHM paths are unique per nekowm instance so that files leaked by a crashed
+ * instance do not collide with ours and can be removed on startup.
+ */
+#define SHM_DIR "/dev/shm/"
+#define SHM_PREFIX ".proxy_backend-"
+
+void neko_view_app_shm_cleanup(void)
+{
+	struct dirent *ent;
+	DIR *dir;
+
+	dir = opendir(SHM_DIR);
+	if (!dir) {
+		GP_WARN("Failed to open '" SHM_DIR "': %s", strerror(errno));
+		return;
+	}
+
+	while ((ent = readdir(dir))) {
+		const char *name = ent->d_name;
+		char *end;
+		long pid;
+
+		if (strncmp(name, SHM_PREFIX, sizeof(SHM_PREFIX) - 1))
+			continue;
+
+		pid = strtol(name + sizeof(SHM_PREFIX) - 1, &end, 10);
+		if (pid <= 0 || *end != '-')
+			continue;
+
+		/* The owner is still running */
+		if (!kill(pid, 0) || errno != ESRCH)
+			continue;
+
+		if (unlinkat(dirfd(dir), name, 0))
+			GP_WARN("Failed to remove '%s': %s", name, strerror(errno));
+		else
+			GP_DEBUG(1, "Removed stale SHM '%s'", name);
+	}
+
+	closedir(dir);
+}
+
+/*
+ * Asks for the SHM to be backed by transparent huge pages, this lowers TLB
+ * misses when the SHM is blitted. Has effect only if huge pages are enabled
+ * for shmem i.e. /sys/kernel/mm/transparent_hugepage/shmem_enabled is set to
+ * 'advise'.
+ */
+static void shm_advise(gp_proxy_shm *shm)
+{
+#ifdef MADV_HUGEPAGE
+	if (madvise(shm->base, shm->size, MADV_HUGEPAGE))
+		GP_DEBUG(2, "madvise(MADV_HUGEPAGE) failed: %s", strerror(errno));
+#else
+	(void) shm;
+#endif
+}
+
+/*
+ * The SHM has a few more rows than the view so that the app does not have to
+ * be reallocated on small changes of the view size. The slack is counted in
+ * the SHM size and so against the SHM pool memory limit.
+ */
+#define SHM_SLACK_DIV 8
+
+static gp_size shm_rows(gp_size h)
+{
+	return h + h / SHM_SLACK_DIV;
+}
+
+static gp_proxy_shm *app_shm_init(gp_size w, gp_size h)
+{
+	static unsigned int proxy_cnt;
+	char path[64];
+
+	gp_pixmap *pixmap = ctx.backend->pixmap;
+	gp_proxy_shm *shm;
+
+	//TODO: Move unique path creation to the library.
+	snprintf(path, sizeof(path), SHM_DIR SHM_PREFIX "%i-%u", (int)getpid(), proxy_cnt++);
+
+	shm = gp_proxy_shm_init(path, w, shm_rows(h), pixmap->pixel_type);
+	if (!shm)
+		return NULL;
+
+	shm_advise(shm);
+	neko_prefault(shm->base, shm->size);
+
+	gp_pixmap_init(&shm->pixmap, w, h, pixmap->pixel_type, shm->base, 0);
+
+	return shm;
+}
+
+/*
+ * Acks and drops the queued updates, used when the app SHM layout changes and
+ * the queued rects no longer match the view.
+ */
+static void app_drop_updates(struct app *app)
+{
+	size_t i, len = gp_vec_len(app->updates);
+
+	if (!len)
+		return;
+
+	for (i = 0; i < len; i++)
+		gp_proxy_cli_rect_updated(app->cli, &app->updates[i]);
+
+	app->updates = gp_vec_del(app->updates, 0, len);
+	updates_pending -= len;
+}
+
 static void app_resize(neko_view *self)
 {
 	struct app *app = APP_PRIV(self->slot);
 
+	app_drop_updates(app);
+
 	/**
-	 * We cannot resize the SHM until app stops using it, so we only
-	 * request unmap in the resize call and remap the application in
+	 * We cannot change the SHM layout until app stops using it, so we
+	 * only request unmap in the resize call and remap the application in
 	 * the message handler.
 	 */
 	gp_proxy_cli_send(app->cli, GP_PROXY_UNMAP, NULL);
@@ -107,18 +421,39 @@ static void app_hide(neko_view *self)
 {
 	struct app *app = APP_PRIV(self->slot);
 
-	if (app->shm) {
-		gp_proxy_shm_exit(app->shm);
-		app->shm = NULL;
-	}
+	app->motion_pending = 0;
+
+	app_drop_updates(app);
 
 	gp_proxy_cli_hide(app->cli);
+
+	/* The app stopped rendering, keep the SHM with the last frame around */
+	neko_shm_pool_put(&app->pool);
+}
+
+/*
+ * Tries to reuse the SHM retained in the pool while the app was hidden.
+ *
+ * Returns non-zero if the SHM can be reused, i.e. the view fits into it.
+ */
+static int app_shm_reuse(neko_view *self, struct app *app)
+{
+	if (!app->shm)
+		return 0;
+
+	neko_shm_pool_get(&app->pool);
+
+	if (app_shm_fits(app, self->w, self->h))
+		return 1;
+
+	neko_shm_pool_evict(&app->pool);
+
+	return 0;
 }
 
 static void app_show(neko_view *self)
 {
 	gp_backend *backend = ctx.backend;
-	static int proxy_cnt;
 
 	struct gp_proxy_coord cur_pos = {
 		.x = backend->event_queue->state.cursor_x - self->x,
@@ -126,18 +461,40 @@ static void app_show(neko_view *self)
 	};
 
 	struct app *app = APP_PRIV(self->slot);
-	char proxy_path[64];
 
-	//TODO: Move unique path creation to the library.
-	snprintf(proxy_path, sizeof(proxy_path), "/dev/shm/.proxy_backend-%i", proxy_cnt++);
+	if (app_shm_reuse(self, app)) {
+		GP_DEBUG(2, "Reusing SHM for app '%s'", app_name(app));
+
+		/* Paint the last frame until the app sends an update */
+		if (app->shm->pixmap.w == self->w && app->shm->pixmap.h == self->h) {
+			neko_blit(&app->shm->pixmap, 0, 0, self->w, self->h,
+			          backend->pixmap, self->x, self->y);
+			neko_view_flip(self);
+		} else {
+			app_shm_map(app, self->w, self->h);
+		}
 
-	app->shm = gp_proxy_shm_init(proxy_path, self->w, self->h, backend->pixmap->pixel_type);
+		goto show;
+	}
+
+	app->shm = app_shm_init(self->w, self->h);
 	if (!app->shm) {
 		GP_WARN("Failed to initialize SHM");
 		//TODO proper error handling
 		return;
 	}
 
+	/* Paint the last frame until the app sends an update */
+	if (app->snapshot) {
+		if (!neko_snapshot_restore(app->snapshot, &app->shm->pixmap)) {
+			neko_blit(&app->shm->pixmap, 0, 0, self->w, self->h,
+			          backend->pixmap, self->x, self->y);
+			neko_view_flip(self);
+		}
+
+		neko_snapshot_free(&app->snapshot);
+	}
+show:
 	gp_proxy_cli_show(app->cli, app->shm, &cur_pos);
 
 	neko_running_apps_changed();
@@ -149,6 +506,118 @@ void neko_view_app_exit(gp_proxy_cli *cli)
 	gp_proxy_cli_send(cli, GP_PROXY_EXIT, NULL);
 }
 
+/*
+ * Returns non-zero if the event has been sent. Motion is held back while the
+ * app socket is congested or the app is not responding, other events, e.g.
+ * key releases, are dropped only when they do not fit into the socket buffer.
+ */
+static int app_send_event(struct app *app, gp_event *ev)
+{
+	int queued = app_queued(app);
+
+	if (app_check_congestion(app, queued) &&
+	    (ev->type == GP_EV_REL || ev->type == GP_EV_ABS)) {
+		GP_DEBUG(3, "Holding event for congested app '%s'", app_name(app));
+		return 0;
+	}
+
+	/* The size of the largest message is an upper bound for an event */
+	if (!app_has_room(app, queued, sizeof(gp_proxy_msg))) {
+		GP_DEBUG(3, "Dropping event for full app '%s' socket", app_name(app));
+		return 0;
+	}
+
+	gp_proxy_cli_event(app->cli, ev);
+
+	return 1;
+}
+
+/*
+ * Motion that could not be sent stays pending and is coalesced with the
+ * motion that comes next.
+ */
+static void app_flush_motion(struct app *app)
+{
+	if (!app->motion_pending)
+		return;
+
+	if (app_send_event(app, &app->motion))
+		app->motion_pending = 0;
+}
+
+static int is_motion(gp_event *ev)
+{
+	return (ev->type == GP_EV_REL && ev->code == GP_EV_REL_POS) ||
+	       (ev->type == GP_EV_ABS && ev->code == GP_EV_ABS_POS);
+}
+
+/*
+ * Merges pointer motion into a single event per main loop iteration, relative
+ * motion is accumulated, for absolute motion the latest position is kept.
+ *
+ * Returns non-zero if the event has been coalesced.
+ */
+static int app_coalesce_motion(struct app *app, gp_event *ev)
+{
+	if (!motion_coalesce || app->motion_raw || !is_motion(ev))
+		return 0;
+
+	if (app->motion_pending && app->motion.type == ev->type) {
+		if (ev->type == GP_EV_REL) {
+			app->motion.rel.rx += ev->rel.rx;
+			app->motion.rel.ry += ev->rel.ry;
+			app->motion.time = ev->time;
+		} else {
+			app->motion = *ev;
+		}
+
+		return 1;
+	}
+
+	app_flush_motion(app);
+
+	app->motion = *ev;
+	app->motion_pending = 1;
+
+	return 1;
+}
+
+static int name_in_list(const char *name, const char *list)
+{
+	size_t len = strlen(name);
+
+	while (*list) {
+		size_t tok_len = strcspn(list, ",");
+
+		if (tok_len == len && !strncmp(list, name, len))
+			return 1;
+
+		list += tok_len;
+
+		if (*list)
+			list++;
+	}
+
+	return 0;
+}
+
+void neko_view_app_motion(int coalesce, const char *raw_apps)
+{
+	GP_DEBUG(1, "Motion coalescing %s raw apps '%s'",
+	         coalesce ? "on" : "off", raw_apps);
+
+	motion_coalesce = coalesce;
+	snprintf(motion_raw_apps, sizeof(motion_raw_apps), "%s", raw_apps);
+}
+
+void neko_view_app_flush_motion(void)
+{
+	size_t i;
+
+	for (i = 0; i < gp_vec_len(neko_apps); i++)
+		app_flush_motion(APP_PRIV(neko_apps[i]));
+}
+
 static void app_event(neko_view *self, gp_event *ev)
 {
 	struct app *app = APP_PRIV(self->slot);
@@ -177,7 +646,14 @@ static void app_event(neko_view *self, gp_event *ev)
 	    gp_ev_any_key_pressed(ev, NEKO_KEYS_MOD_WM))
 		return;
 
-	gp_proxy_cli_event(app->cli, ev);
+	if (app_coalesce_motion(app, ev))
+		return;
+
+	/* Keep the order, the motion happened before this event */
+	app_flush_motion(app);
+	app->motion_pending = 0;
+
+	app_send_event(app, ev);
 }
 
 static const neko_view_slot_ops app_ops = {
@@ -205,6 +681,15 @@ static void err_rem_cli(neko_view_slot *slot, gp_fd *self)
 	//TODO! No cli list? keeps apps in vector?
 	gp_proxy_cli_rem(&apps_list, app->cli);
 
+	updates_pending -= gp_vec_len(app->updates);
+	gp_vec_free(app->updates);
+
+	acks_pending -= gp_vec_len(app->acks);
+	gp_vec_free(app->acks);
+
+	neko_shm_pool_evict(&app->pool);
+	neko_snapshot_free(&app->snapshot);
+
 	neko_view_slot_exit(slot->view);
 
 	free(slot);
@@ -222,40 +707,199 @@ static void on_unmap(neko_view_slot *slot, gp_proxy_cli *cli)
 		return;
 
 	struct app *app = APP_PRIV(slot);
+	gp_size w = slot->view->w, h = slot->view->h;
 
-	if (gp_proxy_shm_resize(app->shm, slot->view->w, slot->view->h) < 0) {
-		GP_WARN("Failed to resize shm!");
-		//TODO: proper error
-		return;
+	/* The SHM is reallocated only if the view does not fit into it */
+	if (!app_shm_fits(app, w, h)) {
+		neko_prefault_cancel(app->shm->base);
+
+		if (gp_proxy_shm_resize(app->shm, w, shm_rows(h)) < 0) {
+			GP_WARN("Failed to resize shm!");
+			//TODO: proper error
+			return;
+		}
+
+		shm_advise(app->shm);
+		neko_prefault(app->shm->base, app->shm->size);
 	}
 
+	app_shm_map(app, slot->view->w, slot->view->h);
+
 	gp_proxy_cli_send(cli, GP_PROXY_MAP, &app->shm->path);
 	gp_proxy_cli_send(cli, GP_PROXY_PIXMAP, &app->shm->pixmap);
 	gp_proxy_cli_send(cli, GP_PROXY_SHOW, NULL);
 }
 
-static void shm_update(neko_view_slot *slot, struct gp_proxy_rect *rect)
+/*
+ * Clips the rectangle sent by the app to the view size.
+ *
+ * Returns zero if there is nothing left to update.
+ */
+static int clip_rect(struct gp_proxy_rect *rect, gp_size w, gp_size h)
 {
-	if (!neko_view_is_shown(slot->view))
-		return;
+	if (rect->x >= w || rect->y >= h) {
+		GP_WARN("Rect %u,%u %ux%u outside of the view %ux%u",
+		        rect->x, rect->y, rect->w, rect->h, w, h);
+		return 0;
+	}
 
+	if (rect->w > w - rect->x) {
+		GP_WARN("Invalid width");
+		rect->w = w - rect->x;
+	}
+
+	if (rect->h > h - rect->y) {
+		GP_WARN("Invalid height");
+		rect->h = h - rect->y;
+	}
+
+	return rect->w && rect->h;
+}
+
+/*
+ * Starts copying the updated rect into the backend pixmap, the copy is done
+ * once neko_blit_wait() returns.
+ *
+ * Returns zero if there is nothing to copy, the rect has been acked then.
+ */
+static int shm_blit(neko_view_slot *slot, struct gp_proxy_rect *rect)
+{
 	neko_view *view = slot->view;
-	gp_size screen_h = view->h;
 	struct app *app = APP_PRIV(slot);
 
-	if (rect->h > screen_h) {
-		GP_WARN("Invalid height");
-		rect->h = screen_h;
+	if (!clip_rect(rect, view->w, view->h)) {
+		gp_proxy_cli_rect_updated(app->cli, rect);
+		return 0;
 	}
 
-	//TODO: Check SIZE!!!
-	gp_blit_xywh_clipped(&app->shm->pixmap,
-	                     rect->x, rect->y, rect->w, rect->h,
-	                     neko_view_pixmap(view), rect->x, rect->y);
+	neko_blit_queue(&app->shm->pixmap, rect->x, rect->y, rect->w, rect->h,
+	                ctx.backend->pixmap, view->x + rect->x, view->y + rect->y);
+
+	return 1;
+}
+
+static void shm_blitted(neko_view_slot *slot, struct gp_proxy_rect *rect)
+{
+	neko_view *view = slot->view;
+	struct app *app = APP_PRIV(slot);
 
 	neko_view_update_rect(view, rect->x, rect->y, rect->w, rect->h);
 
-	gp_proxy_cli_rect_updated(app->cli, rect);
+	/*
+	 * The content is in the backend pixmap now, which works as a front
+	 * buffer, so the app can start rendering the next frame right away.
+	 */
+	if (ack_mode == NEKO_VIEW_APP_ACK_BLIT) {
+		gp_proxy_cli_rect_updated(app->cli, rect);
+		return;
+	}
+
+	/*
+	 * The update is acked once the rect has been flushed to the display,
+	 * the app that waits for the ack before it renders next frame is then
+	 * paced by the display refresh rate.
+	 */
+	if (!GP_VEC_APPEND(app->acks, *rect)) {
+		gp_proxy_cli_rect_updated(app->cli, rect);
+		return;
+	}
+
+	acks_pending++;
+}
+
+static void shm_update(neko_view_slot *slot, struct gp_proxy_rect *rect)
+{
+	struct app *app = APP_PRIV(slot);
+
+	/* Nothing to blit, the app must not wait for the ack anyway */
+	if (!neko_view_is_shown(slot->view)) {
+		gp_proxy_cli_rect_updated(app->cli, rect);
+		return;
+	}
+
+	if (!shm_blit(slot, rect))
+		return;
+
+	neko_blit_wait();
+
+	shm_blitted(slot, rect);
+}
+
+void neko_view_app_blit(void)
+{
+	size_t i, j;
+
+	if (!updates_pending)
+		return;
+
+	for (i = 0; i < gp_vec_len(neko_apps); i++) {
+		struct app *app = APP_PRIV(neko_apps[i]);
+		size_t len = gp_vec_len(app->updates);
+
+		if (!len || !neko_view_is_shown(neko_apps[i]->view))
+			continue;
+
+		for (j = 0; j < len; j++) {
+			if (!shm_blit(neko_apps[i], &app->updates[j]))
+				app->updates[j].w = 0;
+		}
+	}
+
+	/* The rects from all apps are copied in parallel by the blit threads */
+	neko_blit_wait();
+
+	for (i = 0; i < gp_vec_len(neko_apps); i++) {
+		struct app *app = APP_PRIV(neko_apps[i]);
+		size_t len = gp_vec_len(app->updates);
+
+		if (!len)
+			continue;
+
+		if (neko_view_is_shown(neko_apps[i]->view)) {
+			for (j = 0; j < len; j++) {
+				if (app->updates[j].w)
+					shm_blitted(neko_apps[i], &app->updates[j]);
+			}
+		} else {
+			for (j = 0; j < len; j++)
+				gp_proxy_cli_rect_updated(app->cli, &app->updates[j]);
+		}
+
+		app->updates = gp_vec_del(app->updates, 0, len);
+	}
+
+	updates_pending = 0;
+}
+
+void neko_view_app_ack_mode(enum neko_view_app_ack mode)
+{
+	GP_DEBUG(1, "Acking app updates on %s",
+	         mode == NEKO_VIEW_APP_ACK_BLIT ? "blit" : "present");
+
+	ack_mode = mode;
+}
+
+void neko_view_app_presented(void)
+{
+	size_t i, j;
+
+	if (!acks_pending)
+		return;
+
+	for (i = 0; i < gp_vec_len(neko_apps); i++) {
+		struct app *app = APP_PRIV(neko_apps[i]);
+		size_t len = gp_vec_len(app->acks);
+
+		if (!len)
+			continue;
+
+		for (j = 0; j < len; j++)
+			gp_proxy_cli_rect_updated(app->cli, &app->acks[j]);
+
+		app->acks = gp_vec_del(app->acks, 0, len);
+	}
+
+	acks_pending = 0;
 }
 
 enum gp_poll_event_ret neko_view_app_event(gp_fd *self)
@@ -269,6 +913,10 @@ enum gp_poll_event_ret neko_view_app_event(gp_fd *self)
 		return 0;
 	}
 
+	/* The app is alive, check if it has caught up with the events */
+	if (app->congested_since)
+		app_check_congestion(app, app_queued(app));
+
 	for (;;) {
 		if (gp_proxy_cli_msg(app->cli, &msg)) {
 			err_rem_cli(slot, self);
@@ -280,12 +928,24 @@ enum gp_poll_event_ret neko_view_app_event(gp_fd *self)
 
 		switch (msg->type) {
 		case GP_PROXY_UNMAP:
+			app_drop_updates(app);
 			on_unmap(slot, app->cli);
 		break;
 		case GP_PROXY_UPDATE:
-			shm_update(slot, &msg->rect.rect);
+			/*
+			 * Blitted after the input events have been dispatched
+			 * so that a large update does not delay them.
+			 */
+			if (!GP_VEC_APPEND(app->updates, msg->rect.rect)) {
+				shm_update(slot, &msg->rect.rect);
+				break;
+			}
+
+			updates_pending++;
 		break;
 		case GP_PROXY_NAME:
+			app->motion_raw = app->cli->name &&
+			                  name_in_list(app->cli->name, motion_raw_apps);
 			neko_cli_connected(app->cli);
 		break;
 		}
@@ -52,6 +52,92 @@ gp_proxy_cli *neko_view_app_cli(neko_view_slot *self);
  */
 void neko_view_app_exit(gp_proxy_cli *cli);
 
+/**
+ * @brief When is an app update acked.
+ *
+ * The app cannot touch its SHM buffer until the update is acked.
+ */
+enum neko_view_app_ack {
+	/**
+	 * @brief Updates are acked once they were presented on the display.
+	 *
+	 * This paces the apps by the display refresh rate.
+	 */
+	NEKO_VIEW_APP_ACK_PRESENT,
+	/**
+	 * @brief Updates are acked once copied from the SHM.
+	 *
+	 * The backend pixmap works as a front buffer and the app SHM as a back
+	 * buffer, the app can render next frame while the compositor presents
+	 * the previous one.
+	 */
+	NEKO_VIEW_APP_ACK_BLIT,
+	/** @brief Invalid value, used for parsing the config. */
+	NEKO_VIEW_APP_ACK_INVALID = -1,
+};
+
+/**
+ * @brief Sets when app updates are acked.
+ *
+ * @param mode An ack mode.
+ */
+void neko_view_app_ack_mode(enum neko_view_app_ack mode);
+
+/**
+ * @brief Called after the screen damage has been flushed to the display.
+ *
+ * Acks all app updates that were waiting for the damage to be presented.
+ */
+void neko_view_app_presented(void);
+
+/**
+ * @brief Sets up pointer motion coalescing.
+ *
+ * Pointer motion events for an app are merged into a single event per main
+ * loop iteration. Other events are never reordered, pending motion is sent
+ * before them, and dropped only when they do not fit into the app socket.
+ *
+ * @param coalesce Enables the coalescing.
+ * @param raw_apps A comma separated list of app names that get all motion
+ *                 events, e.g. drawing apps.
+ */
+void neko_view_app_motion(int coalesce, const char *raw_apps);
+
+/**
+ * @brief Sends coalesced motion events to the apps.
+ *
+ * Called from the main loop after all input events were processed.
+ */
+void neko_view_app_flush_motion(void);
+
+/**
+ * @brief Blits the queued app updates to the screen.
+ *
+ * App updates are queued when they are read from the app sockets and blitted
+ * in a batch after the input events were processed, so that the input
+ * latency does not depend on the amount of data the apps render.
+ */
+void neko_view_app_blit(void);
+
+/**
+ * @brief Returns if an app reads the messages we send to it.
+ *
+ * An app whose socket stays congested for a few seconds is marked as not
+ * responding, pointer motion is held back until it catches up.
+ *
+ * @param self An app view slot.
+ *
+ * @return Zero if app is not responding.
+ */
+int neko_view_app_responding(neko_view_slot *self);
+
+/**
+ * @brief Removes app SHM files leaked by nekowm instances that are not running.
+ *
+ * Should be called once on startup.
+ */
+void neko_view_app_shm_cleanup(void);
+
 static inline size_t neko_view_app_cnt(void)
 {
 	return gp_vec_len(neko_apps);
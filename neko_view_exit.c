@@ -15,6 +15,7 @@
 #include "neko_keybindings.h"
 #include "neko_view.h"
 #include "neko_ctx.h"
+#include "neko_damage.h"
 #include "neko_view_app.h"
 #include "neko_view_exit.h"
 #include "neko_logo.h"
@@ -61,8 +62,9 @@ static void print_poweroff(neko_view *self, gp_size w, gp_size h, gp_size ta)
 		         ctx.col_fg, ctx.col_bg,
 	                 "\u00ab Machine is powered off \u00bb");
 	neko_view_flip(self);
+	/* Full refresh leaves e-ink displays without ghosting */
+	neko_damage_flush_full();
 	gp_backend_ev_poll(ctx.backend);
-	//TODO: Fix e-ink to do a final refresh
 	sleep(1);
 }
 
@@ -97,6 +99,7 @@ static void exit_show(neko_view *self)
 
 	if (!neko_view_app_cnt() || timeout <= 0) {
 		gp_backend_timer_stop(ctx.backend, &exit_timer);
+		neko_damage_flush();
 		sleep(1);
 		switch (exit_type) {
 		case NEKO_VIEW_EXIT_POWEROFF:
@@ -70,8 +70,9 @@ static void draw_entry(size_t idx, gp_pixmap *pixmap, gp_pixel fg, gp_pixel bg,
 
 	width = gp_print(pixmap, ctx.font, x, y,
 	                 GP_ALIGN_RIGHT|GP_VALIGN_BOTTOM,
-		         fg, bg, "%zu: '%s'%s%s", idx,
-	                 cli->name, shown, view_name);
+		         fg, bg, "%zu: '%s'%s%s%s", idx,
+	                 cli->name, shown, view_name,
+	                 neko_view_app_responding(neko_apps[idx]) ? "" : " (not responding)");
 
 	/* And now traverse the tree and draw small filled rectangle at that place */
 	if (app_view) {
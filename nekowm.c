@@ -5,6 +5,8 @@
 
  */
 
+#include <ctype.h>
+#include <errno.h>
 #include <signal.h>
 #include <gfxprim.h>
 #include <sys/socket.h>
@@ -15,7 +17,15 @@
 #include <backends/gp_proxy_cli.h>
 
 #include "neko_keybindings.h"
+#include "neko_blit.h"
+#include "neko_config.h"
 #include "neko_ctx.h"
+#include "neko_eink.h"
+#include "neko_flush.h"
+#include "neko_frame.h"
+#include "neko_prefault.h"
+#include "neko_shm_pool.h"
+#include "neko_snapshot.h"
 #include "neko_view.h"
 #include "neko_view_app_launcher.h"
 #include "neko_view_running_apps.h"
@@ -99,31 +109,40 @@ static void backend_event(gp_backend *b)
 			if (!gp_ev_any_key_pressed(ev, NEKO_KEYS_MOD_WM))
 				break;
 
-			if (neko_process_keybindings(ev->key.key)) {
+			if (neko_process_keybindings(ev->key.key))
 				return;
-			} else if (ev->key.key == NEKO_KEYS_EXIT) {
+
+			switch (neko_keybindings_lookup(ev->key.key)) {
+			case NEKO_KEYS_EXIT_IDX:
 				do_exit(NEKO_VIEW_EXIT_QUIT);
-			} else if (ev->key.key == NEKO_KEYS_POWEROFF) {
+			break;
+			case NEKO_KEYS_POWEROFF_IDX:
 				do_exit(NEKO_VIEW_EXIT_POWEROFF);
-			} else if (ev->key.key ==  NEKO_KEYS_VIRT_SCREENS_LEFT) {
+			break;
+			case NEKO_KEYS_VIRT_SCREENS_LEFT_IDX:
 				//TODO: Move to VIEWS
 				if (cur_view != 0) {
 					neko_view_hide(&main_views[cur_view]);
 					cur_view--;
 					neko_view_show(&main_views[cur_view]);
 				}
-			} else if (ev->key.key == NEKO_KEYS_VIRT_SCREENS_RIGHT) {
+			break;
+			case NEKO_KEYS_VIRT_SCREENS_RIGHT_IDX:
 				//TODO: Move to VIEWS
 				if (cur_view < NEKO_MAIN_VIEWS-1) {
 					neko_view_hide(&main_views[cur_view]);
 					cur_view++;
 					neko_view_show(&main_views[cur_view]);
 				}
-			} else if (ev->key.key == NEKO_KEYS_ROTATE) {
+			break;
+			case NEKO_KEYS_ROTATE_IDX:
 				//TODO: Add gp_backend_rotate_*() functions and
 				//generate resize events in backend on rotate!
-				gp_pixmap_rotate_cw(backend->pixmap);
+				neko_flush_rotate_cw();
 				resize_views(gp_pixmap_w(backend->pixmap), gp_pixmap_h(backend->pixmap));
+			break;
+			default:
+			break;
 			}
 
 			switch (ev->val) {
@@ -153,6 +172,7 @@ static void backend_event(gp_backend *b)
 			case GP_EV_SYS_RENDER_START:
 				return;
 			case GP_EV_SYS_RENDER_RESIZE:
+				neko_flush_resize();
 				resize_views(ev->resize.w, ev->resize.h);
 				return;
 			}
@@ -212,21 +232,6 @@ static enum gp_poll_event_ret server_event(gp_fd *self)
 	return 0;
 }
 
-struct neko_config {
-	char backend_opts[256];
-	char font_family[256];
-	char rotate[4];
-	char theme[64];
-};
-
-static struct gp_json_struct neko_cfg_desc[] = {
-	GP_JSON_SERDES_STR_CPY(struct neko_config, backend_opts, GP_JSON_SERDES_OPTIONAL, 256),
-	GP_JSON_SERDES_STR_CPY(struct neko_config, font_family, GP_JSON_SERDES_OPTIONAL, 256),
-	GP_JSON_SERDES_STR_CPY(struct neko_config, rotate, GP_JSON_SERDES_OPTIONAL, 4),
-	GP_JSON_SERDES_STR_CPY(struct neko_config, theme, GP_JSON_SERDES_OPTIONAL, 64),
-	{}
-};
-
 static void print_help(const char *name)
 {
 	printf("%s -b backend_options -f font_family -r\n", name);
@@ -246,7 +251,7 @@ enum display_rotation {
 
 static void load_cfg(struct neko_config *cfg)
 {
-	gp_json_load_struct("/etc/nekowm.conf", neko_cfg_desc, cfg);
+	neko_config_load("/etc/nekowm.conf", cfg);
 }
 
 static enum display_rotation str_to_rot(char *rotate)
@@ -271,6 +276,44 @@ static enum neko_theme str_to_theme(const char *theme)
 		return NEKO_THEME_INVALID;
 }
 
+static enum neko_view_app_ack str_to_ack(const char *ack)
+{
+	if (!strcmp(ack, "present"))
+		return NEKO_VIEW_APP_ACK_PRESENT;
+	else if (!strcmp(ack, "blit"))
+		return NEKO_VIEW_APP_ACK_BLIT;
+	else
+		return NEKO_VIEW_APP_ACK_INVALID;
+}
+
+static int str_to_size(const char *str, size_t *size)
+{
+	char *end;
+	unsigned long val;
+
+	/* The strtoul() would silently negate a number with a minus sign */
+	if (!isdigit((unsigned char)*str))
+		return 1;
+
+	errno = 0;
+	val = strtoul(str, &end, 10);
+	if (errno || *end)
+		return 1;
+
+	*size = val;
+	return 0;
+}
+
+static int str_to_bool(const char *str)
+{
+	if (!strcmp(str, "yes"))
+		return 1;
+	else if (!strcmp(str, "no"))
+		return 0;
+	else
+		return -1;
+}
+
 static void show_logo(gp_backend *backend)
 {
 	neko_logo_render(backend->pixmap, &neko_logo_text, 0);
@@ -320,8 +363,25 @@ int main(int argc, char *argv[])
 	struct neko_config cfg = {
 		.font_family = "haxor-narrow-18",
 		.theme = "dark",
+		.update_ack = "present",
+		.shm_pool_apps = "4",
+		.shm_pool_mem = "32",
+		.snapshot_mem = "16",
+		.snapshot_rle = "no",
+		.shm_prefault = "no",
+		.flush_diff = "no",
+		.blit_threads = "no",
+		.eink = "no",
+		.eink_partial_max = "20",
+		.eink_idle = "10",
+		.motion_coalesce = "yes",
 	};
+	size_t shm_pool_apps, shm_pool_mem, snapshot_mem;
+	size_t eink_partial_max, eink_idle;
+	int snapshot_rle, shm_prefault, flush_diff, eink;
+	int motion_coalesce;
 	enum neko_theme theme;
+	enum neko_view_app_ack update_ack;
 	enum display_rotation display_rotation = DISPLAY_ROTATE_0;
 
 	load_cfg(&cfg);
@@ -334,6 +394,57 @@ int main(int argc, char *argv[])
 		theme = NEKO_THEME_DARK;
 	}
 
+	update_ack = str_to_ack(cfg.update_ack);
+
+	if (update_ack == NEKO_VIEW_APP_ACK_INVALID) {
+		fprintf(stderr, "Invalid update ack from config!\n");
+		update_ack = NEKO_VIEW_APP_ACK_PRESENT;
+	}
+
+	neko_view_app_ack_mode(update_ack);
+	neko_view_app_shm_cleanup();
+
+	motion_coalesce = str_to_bool(cfg.motion_coalesce);
+	if (motion_coalesce < 0) {
+		fprintf(stderr, "Invalid motion coalesce from config!\n");
+		motion_coalesce = 1;
+	}
+
+	neko_view_app_motion(motion_coalesce, cfg.motion_raw_apps);
+
+	if (str_to_size(cfg.shm_pool_apps, &shm_pool_apps)) {
+		fprintf(stderr, "Invalid SHM pool apps from config!\n");
+		shm_pool_apps = 4;
+	}
+
+	if (str_to_size(cfg.shm_pool_mem, &shm_pool_mem)) {
+		fprintf(stderr, "Invalid SHM pool memory from config!\n");
+		shm_pool_mem = 32;
+	}
+
+	neko_shm_pool_init(shm_pool_apps, shm_pool_mem * 1024 * 1024);
+
+	if (str_to_size(cfg.snapshot_mem, &snapshot_mem)) {
+		fprintf(stderr, "Invalid snapshot memory from config!\n");
+		snapshot_mem = 16;
+	}
+
+	snapshot_rle = str_to_bool(cfg.snapshot_rle);
+	if (snapshot_rle < 0) {
+		fprintf(stderr, "Invalid snapshot RLE from config!\n");
+		snapshot_rle = 0;
+	}
+
+	neko_snapshot_init(snapshot_mem * 1024 * 1024, snapshot_rle);
+
+	shm_prefault = str_to_bool(cfg.shm_prefault);
+	if (shm_prefault < 0) {
+		fprintf(stderr, "Invalid SHM prefault from config!\n");
+		shm_prefault = 0;
+	}
+
+	neko_prefault_init(shm_prefault);
+
 	signal(SIGPIPE, SIG_IGN);
 	signal(SIGTERM, trigger_exit);
 	signal(SIGINT, trigger_exit);
@@ -407,8 +518,47 @@ int main(int argc, char *argv[])
 	}
 
 	neko_ctx_init(backend, theme, cfg.font_family);
+	neko_blit_init(backend->pixmap->pixel_type);
+
+	if (neko_blit_threads(cfg.blit_threads))
+		fprintf(stderr, "Invalid blit threads '%s' from config!\n", cfg.blit_threads);
+
+	if (neko_frame_init(cfg.frame_rate))
+		fprintf(stderr, "Invalid frame rate '%s' from config!\n", cfg.frame_rate);
+
+	flush_diff = str_to_bool(cfg.flush_diff);
+	if (flush_diff < 0) {
+		fprintf(stderr, "Invalid flush diff from config!\n");
+		flush_diff = 0;
+	}
+
+	neko_flush_init(flush_diff);
+
+	eink = str_to_bool(cfg.eink);
+	if (eink < 0) {
+		fprintf(stderr, "Invalid eink from config!\n");
+		eink = 0;
+	}
+
+	if (str_to_size(cfg.eink_partial_max, &eink_partial_max)) {
+		fprintf(stderr, "Invalid eink partial max from config!\n");
+		eink_partial_max = 20;
+	}
+
+	if (str_to_size(cfg.eink_idle, &eink_idle)) {
+		fprintf(stderr, "Invalid eink idle from config!\n");
+		eink_idle = 10;
+	}
+
+	if (eink)
+		neko_eink_init(eink_partial_max, eink_idle * 1000);
 
 	show_logo(backend);
+	neko_flush_resync();
+
+	/* The "auto" cost is measured by flushing the logo */
+	if (neko_flush_cost(cfg.flush_cost))
+		fprintf(stderr, "Invalid flush cost '%s' from config!\n", cfg.flush_cost);
 
 	gp_size w = gp_pixmap_w(backend->pixmap);
 	gp_size h = gp_pixmap_h(backend->pixmap);
@@ -463,10 +613,13 @@ int main(int argc, char *argv[])
 	gp_backend_poll_add(backend, &server_fd);
 
 	for (;;) {
+		neko_frame_schedule();
 		gp_backend_wait(backend);
 		if (sig_exit)
 			do_exit(NEKO_VIEW_EXIT_QUIT);
 		backend_event(backend);
+		neko_view_app_flush_motion();
+		neko_view_app_blit();
 	}
 
 	return 0;
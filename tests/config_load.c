@@ -0,0 +1,138 @@
+//SPDX-License-Identifier: GPL-2.0-or-later
+/*
+
+   Copyright (c) 2019-2025 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Writes a config with every option set to a different value, loads it and
+ * checks that each option ended up in the right field.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "neko_config.h"
+
+#define OPT(name) {#name, offsetof(struct neko_config, name)}
+
+static struct opt {
+	const char *id;
+	size_t offset;
+} opts[] = {
+	OPT(backend_opts),
+	OPT(blit_threads),
+	OPT(eink),
+	OPT(eink_idle),
+	OPT(eink_partial_max),
+	OPT(flush_cost),
+	OPT(flush_diff),
+	OPT(font_family),
+	OPT(frame_rate),
+	OPT(motion_coalesce),
+	OPT(motion_raw_apps),
+	OPT(rotate),
+	OPT(shm_pool_apps),
+	OPT(shm_pool_mem),
+	OPT(shm_prefault),
+	OPT(snapshot_mem),
+	OPT(snapshot_rle),
+	OPT(theme),
+	OPT(update_ack),
+};
+
+#define OPTS_CNT (sizeof(opts)/sizeof(*opts))
+
+static int check_desc(void)
+{
+	size_t i;
+
+	for (i = 0; neko_config_desc[i].id; i++) {
+		if (i && strcmp(neko_config_desc[i-1].id, neko_config_desc[i].id) >= 0) {
+			printf("FAIL: '%s' and '%s' are not sorted\n",
+			       neko_config_desc[i-1].id, neko_config_desc[i].id);
+			return 1;
+		}
+	}
+
+	if (i != OPTS_CNT) {
+		printf("FAIL: config has %zu options, test checks %zu\n", i, OPTS_CNT);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int write_config(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	size_t i;
+
+	if (!f) {
+		printf("FAIL: fopen(%s)\n", path);
+		return 1;
+	}
+
+	fprintf(f, "{\n");
+
+	/* Values have to fit into the shortest option */
+	for (i = 0; i < OPTS_CNT; i++)
+		fprintf(f, "\t\"%s\": \"%zu\"%s\n", opts[i].id, i, i + 1 < OPTS_CNT ? "," : "");
+
+	fprintf(f, "}\n");
+
+	return fclose(f);
+}
+
+int main(void)
+{
+	char path[] = "/tmp/nekowm-config-XXXXXX";
+	struct neko_config cfg = {};
+	int fd, ret = 0;
+	size_t i;
+
+	if (check_desc())
+		return 1;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		printf("FAIL: mkstemp()\n");
+		return 1;
+	}
+
+	close(fd);
+
+	if (write_config(path))
+		goto err;
+
+	if (neko_config_load(path, &cfg)) {
+		printf("FAIL: neko_config_load()\n");
+		goto err;
+	}
+
+	for (i = 0; i < OPTS_CNT; i++) {
+		const char *val = (const char *)&cfg + opts[i].offset;
+		char exp[8];
+
+		snprintf(exp, sizeof(exp), "%zu", i);
+
+		if (strcmp(val, exp)) {
+			printf("FAIL: '%s' = '%s' expected '%s'\n", opts[i].id, val, exp);
+			ret = 1;
+		}
+	}
+
+	unlink(path);
+
+	if (!ret)
+		printf("PASS: all %zu options loaded\n", OPTS_CNT);
+
+	return ret;
+err:
+	unlink(path);
+	return 1;
+}